@@ -22,6 +22,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <gio/gio.h>
 
@@ -83,6 +84,8 @@ enum
   PROP_INITIAL_TONES,
   PROP_DEFERRED_TONES,
 
+  PROP_COALESCE_MEMBER_CHANGES,
+
   LAST_PROPERTY
 };
 
@@ -95,27 +98,55 @@ enum
 static guint signals[LAST_SIGNAL] = { 0, };
 
 
+/* Most calls have very few members, which are kept in the channel itself */
+#define N_INLINE_MEMBERS 4
+
+typedef struct {
+    TpHandle handle;
+    TpyCallMemberFlags flags;
+} CallMember;
+
 /* private structure */
 struct _TpyBaseCallChannelPrivate
 {
   gboolean dispose_has_run;
 
   GList *contents;
+  /* object path => GList link in contents; keys are owned by the contents */
+  GHashTable *content_links;
+  /* number of contents of each TpMediaStreamType */
+  guint n_contents[NUM_TP_MEDIA_STREAM_TYPES];
+  /* Contents property; borrowed paths, NULL until needed again after the
+   * set of contents changes */
+  GPtrArray *content_paths;
 
   gchar *initial_audio_name;
   gchar *initial_video_name;
 
   TpyCallState state;
   TpyCallFlags flags;
-  GHashTable *details;
-  GValueArray *reason;
 
+  /* NULL until tones are first played */
   TpDTMFPlayer *dtmf_player;
   gchar *deferred_tones;
-  gboolean have_some_audio;
 
-  /* CallMember handle => flag hash table */
-  GHashTable *call_members;
+  /* Members are kept in inline_members while there are at most
+   * N_INLINE_MEMBERS of them. Beyond that they move to members_table
+   * (handle => flags), which then holds all of them. */
+  CallMember inline_members[N_INLINE_MEMBERS];
+  guint n_inline_members;
+  GHashTable *members_table;
+  /* handle => flags for inline members, kept up to date once built; NULL
+   * until first needed */
+  GHashTable *members_cache;
+
+  /* Member changes not yet signalled: handle => flags, and the set of
+   * removed handles. Both are NULL until first needed. */
+  GHashTable *member_changes;
+  GHashTable *member_removals;
+  guint member_batch_depth;
+  gboolean coalesce_member_changes;
+  guint member_changes_idle_id;
 };
 
 static void
@@ -156,18 +187,18 @@ tpy_base_call_channel_init (TpyBaseCallChannel *self)
 
   self->priv = priv;
 
-  priv->reason = tp_value_array_build (3,
-    G_TYPE_UINT, 0,
-    G_TYPE_UINT, 0,
-    G_TYPE_STRING, "",
-    G_TYPE_INVALID);
+  priv->content_links = g_hash_table_new (g_str_hash, g_str_equal);
+}
 
-  priv->details = tp_asv_new (NULL, NULL);
+static TpDTMFPlayer *
+get_dtmf_player (TpyBaseCallChannel *self)
+{
+  TpyBaseCallChannelPrivate *priv = self->priv;
 
-  priv->call_members = g_hash_table_new (g_direct_hash, g_direct_equal);
+  if (priv->dtmf_player != NULL)
+    return priv->dtmf_player;
 
   priv->dtmf_player = tp_dtmf_player_new ();
-  priv->have_some_audio = FALSE;
 
   tp_g_signal_connect_object (priv->dtmf_player, "finished",
       G_CALLBACK (tp_svc_channel_interface_dtmf_emit_stopped_tones), self,
@@ -176,11 +207,136 @@ tpy_base_call_channel_init (TpyBaseCallChannel *self)
   tp_g_signal_connect_object (priv->dtmf_player, "tones-deferred",
       G_CALLBACK (tpy_base_call_channel_tones_deferred_cb), self,
       G_CONNECT_SWAPPED);
+
+  return priv->dtmf_player;
+}
+
+/* The state reason and details are never changed from these, so all
+ * channels share them */
+static GValueArray *
+get_state_reason (void)
+{
+  static GValueArray *reason = NULL;
+
+  if (G_UNLIKELY (reason == NULL))
+    reason = tp_value_array_build (3,
+      G_TYPE_UINT, 0,
+      G_TYPE_UINT, 0,
+      G_TYPE_STRING, "",
+      G_TYPE_INVALID);
+
+  return reason;
+}
+
+static GHashTable *
+get_state_details (void)
+{
+  static GHashTable *details = NULL;
+
+  if (G_UNLIKELY (details == NULL))
+    details = tp_asv_new (NULL, NULL);
+
+  return details;
+}
+
+static CallMember *
+find_inline_member (TpyBaseCallChannel *self,
+    TpHandle handle)
+{
+  TpyBaseCallChannelPrivate *priv = self->priv;
+  guint i;
+
+  for (i = 0; i < priv->n_inline_members; i++)
+    if (priv->inline_members[i].handle == handle)
+      return priv->inline_members + i;
+
+  return NULL;
+}
+
+static gboolean
+has_member (TpyBaseCallChannel *self,
+    TpHandle handle)
+{
+  TpyBaseCallChannelPrivate *priv = self->priv;
+
+  if (priv->members_table != NULL)
+    return g_hash_table_lookup_extended (priv->members_table,
+        GUINT_TO_POINTER (handle), NULL, NULL);
+
+  return find_inline_member (self, handle) != NULL;
+}
+
+/* Returns a borrowed handle => flags hash table of the members, as used by
+ * CallMembers */
+static GHashTable *
+get_members (TpyBaseCallChannel *self)
+{
+  TpyBaseCallChannelPrivate *priv = self->priv;
+  guint i;
+
+  if (priv->members_table != NULL)
+    return priv->members_table;
+
+  if (priv->members_cache != NULL)
+    return priv->members_cache;
+
+  priv->members_cache = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  for (i = 0; i < priv->n_inline_members; i++)
+    g_hash_table_insert (priv->members_cache,
+        GUINT_TO_POINTER (priv->inline_members[i].handle),
+        GUINT_TO_POINTER (priv->inline_members[i].flags));
+
+  return priv->members_cache;
 }
 
 static void tpy_base_call_channel_dispose (GObject *object);
 static void tpy_base_call_channel_finalize (GObject *object);
 
+static gboolean
+have_some_audio (TpyBaseCallChannel *self)
+{
+  return self->priv->n_contents[TP_MEDIA_STREAM_TYPE_AUDIO] > 0;
+}
+
+static GPtrArray *
+get_content_paths (TpyBaseCallChannel *self)
+{
+  TpyBaseCallChannelPrivate *priv = self->priv;
+  GList *l;
+
+  if (priv->content_paths != NULL)
+    return priv->content_paths;
+
+  priv->content_paths = g_ptr_array_sized_new (
+      g_hash_table_size (priv->content_links));
+
+  for (l = priv->contents; l != NULL; l = g_list_next (l))
+    {
+      TpyBaseCallContent *c = TPY_BASE_CALL_CONTENT (l->data);
+      g_ptr_array_add (priv->content_paths,
+        (gpointer) tpy_base_call_content_get_object_path (c));
+    }
+
+  return priv->content_paths;
+}
+
+static void
+clear_contents (TpyBaseCallChannel *self)
+{
+  TpyBaseCallChannelPrivate *priv = self->priv;
+  GList *contents = priv->contents;
+
+  priv->contents = NULL;
+  g_hash_table_remove_all (priv->content_links);
+  memset (priv->n_contents, 0, sizeof (priv->n_contents));
+  tp_clear_pointer (&priv->content_paths, g_ptr_array_unref);
+
+  g_list_foreach (contents, (GFunc) tpy_base_call_content_deinit, NULL);
+  g_list_foreach (contents, (GFunc) g_object_unref, NULL);
+  g_list_free (contents);
+}
+
 static void
 tpy_base_call_channel_get_property (GObject    *object,
     guint       property_id,
@@ -209,21 +365,10 @@ tpy_base_call_channel_get_property (GObject    *object,
           g_value_set_boolean (value, TRUE);
         break;
       case PROP_CONTENTS:
-        {
-          GPtrArray *arr = g_ptr_array_sized_new (2);
-          GList *l;
-
-          for (l = priv->contents; l != NULL; l = g_list_next (l))
-            {
-              TpyBaseCallContent *c = TPY_BASE_CALL_CONTENT (l->data);
-              g_ptr_array_add (arr,
-                (gpointer) tpy_base_call_content_get_object_path (c));
-            }
-
-          g_value_set_boxed (value, arr);
-          g_ptr_array_free (arr, TRUE);
-          break;
-        }
+        /* the cached array lives until the set of contents changes, which
+         * can't happen while the caller still holds this value */
+        g_value_set_static_boxed (value, get_content_paths (self));
+        break;
       case PROP_HARDWARE_STREAMING:
         g_value_set_boolean (value, FALSE);
         break;
@@ -234,16 +379,16 @@ tpy_base_call_channel_get_property (GObject    *object,
         g_value_set_uint (value, priv->flags);
         break;
       case PROP_CALL_STATE_DETAILS:
-        g_value_set_boxed (value, priv->details);
+        g_value_set_static_boxed (value, get_state_details ());
         break;
       case PROP_CALL_STATE_REASON:
-        g_value_set_boxed (value, priv->reason);
+        g_value_set_static_boxed (value, get_state_reason ());
         break;
       case PROP_CALL_MEMBERS:
-        g_value_set_boxed (value, priv->call_members);
+        g_value_set_static_boxed (value, get_members (self));
         break;
       case PROP_CURRENTLY_SENDING_TONES:
-        g_value_set_boolean (value,
+        g_value_set_boolean (value, priv->dtmf_player != NULL &&
             tp_dtmf_player_is_active (priv->dtmf_player));
         break;
       case PROP_INITIAL_TONES:
@@ -256,6 +401,9 @@ tpy_base_call_channel_get_property (GObject    *object,
         else
           g_value_set_static_string (value, "");
         break;
+      case PROP_COALESCE_MEMBER_CHANGES:
+        g_value_set_boolean (value, priv->coalesce_member_changes);
+        break;
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
         break;
@@ -285,12 +433,29 @@ tpy_base_call_channel_set_property (GObject *object,
       case PROP_INITIAL_VIDEO_NAME:
         priv->initial_video_name = g_value_dup_string (value);
         break;
+      case PROP_COALESCE_MEMBER_CHANGES:
+        tpy_base_call_channel_set_coalesce_member_changes (self,
+            g_value_get_boolean (value));
+        break;
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
         break;
   }
 }
 
+/* call_props and dtmf_props hold property IDs, so D-Bus properties are read
+ * from get_property without going through their GParamSpecs */
+static void
+tpy_base_call_channel_get_dbus_property (GObject *object,
+    GQuark iface,
+    GQuark name,
+    GValue *value,
+    gpointer getter_data)
+{
+  tpy_base_call_channel_get_property (object, GPOINTER_TO_UINT (getter_data),
+      value, NULL);
+}
+
 static void
 tpy_base_call_channel_fill_immutable_properties (
     TpBaseChannel *chan,
@@ -319,24 +484,27 @@ tpy_base_call_channel_class_init (
       TP_BASE_CHANNEL_CLASS (tpy_base_call_channel_class);
   GParamSpec *param_spec;
   static TpDBusPropertiesMixinPropImpl call_props[] = {
-      { "CallMembers", "call-members", NULL },
-      { "MutableContents", "mutable-contents", NULL },
-      { "InitialAudio", "initial-audio", NULL },
-      { "InitialVideo", "initial-video", NULL },
-      { "InitialAudioName", "initial-audio-name", NULL },
-      { "InitialVideoName", "initial-video-name", NULL },
-      { "Contents", "contents", NULL },
-      { "HardwareStreaming", "hardware-streaming", NULL },
-      { "CallState", "call-state", NULL },
-      { "CallFlags", "call-flags", NULL },
-      { "CallStateReason",  "call-state-reason", NULL },
-      { "CallStateDetails", "call-state-details", NULL },
+      { "CallMembers", GUINT_TO_POINTER (PROP_CALL_MEMBERS), NULL },
+      { "MutableContents", GUINT_TO_POINTER (PROP_MUTABLE_CONTENTS), NULL },
+      { "InitialAudio", GUINT_TO_POINTER (PROP_INITIAL_AUDIO), NULL },
+      { "InitialVideo", GUINT_TO_POINTER (PROP_INITIAL_VIDEO), NULL },
+      { "InitialAudioName", GUINT_TO_POINTER (PROP_INITIAL_AUDIO_NAME), NULL },
+      { "InitialVideoName", GUINT_TO_POINTER (PROP_INITIAL_VIDEO_NAME), NULL },
+      { "Contents", GUINT_TO_POINTER (PROP_CONTENTS), NULL },
+      { "HardwareStreaming", GUINT_TO_POINTER (PROP_HARDWARE_STREAMING),
+        NULL },
+      { "CallState", GUINT_TO_POINTER (PROP_CALL_STATE), NULL },
+      { "CallFlags", GUINT_TO_POINTER (PROP_CALL_FLAGS), NULL },
+      { "CallStateReason", GUINT_TO_POINTER (PROP_CALL_STATE_REASON), NULL },
+      { "CallStateDetails", GUINT_TO_POINTER (PROP_CALL_STATE_DETAILS),
+        NULL },
       { NULL }
   };
  static TpDBusPropertiesMixinPropImpl dtmf_props[] = {
-      { "CurrentlySendingTones", "currently-sending-tones", NULL },
-      { "InitialTones", "initial-tones", NULL },
-      { "DeferredTones", "deferred-tones", NULL },
+      { "CurrentlySendingTones",
+        GUINT_TO_POINTER (PROP_CURRENTLY_SENDING_TONES), NULL },
+      { "InitialTones", GUINT_TO_POINTER (PROP_INITIAL_TONES), NULL },
+      { "DeferredTones", GUINT_TO_POINTER (PROP_DEFERRED_TONES), NULL },
       { NULL }
   };
 
@@ -470,15 +638,24 @@ tpy_base_call_channel_class_init (
   g_object_class_install_property (object_class, PROP_DEFERRED_TONES,
       param_spec);
 
+  param_spec = g_param_spec_boolean ("coalesce-member-changes",
+      "Coalesce member changes",
+      "If true, member changes made during one main loop iteration are "
+      "signalled together in a single CallMembersChanged",
+      FALSE,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (object_class, PROP_COALESCE_MEMBER_CHANGES,
+      param_spec);
+
   tp_dbus_properties_mixin_implement_interface (object_class,
       TPY_IFACE_QUARK_CHANNEL_TYPE_CALL,
-      tp_dbus_properties_mixin_getter_gobject_properties,
+      tpy_base_call_channel_get_dbus_property,
       NULL,
       call_props);
 
   tp_dbus_properties_mixin_implement_interface (object_class,
       TP_IFACE_QUARK_CHANNEL_INTERFACE_DTMF,
-      tp_dbus_properties_mixin_getter_gobject_properties,
+      tpy_base_call_channel_get_dbus_property,
       NULL,
       dtmf_props);
 }
@@ -496,11 +673,22 @@ tpy_base_call_channel_dispose (GObject *object)
 
   self->priv->dispose_has_run = TRUE;
 
-  g_list_foreach (priv->contents, (GFunc) tpy_base_call_content_deinit, NULL);
-  g_list_foreach (priv->contents, (GFunc) g_object_unref, NULL);
-  tp_clear_pointer (&priv->contents, g_list_free);
+  clear_contents (self);
 
-  tp_clear_pointer (&priv->call_members, g_hash_table_unref);
+  if (priv->member_changes_idle_id != 0)
+    {
+      g_source_remove (priv->member_changes_idle_id);
+      priv->member_changes_idle_id = 0;
+    }
+
+  tp_clear_object (&priv->dtmf_player);
+
+  priv->n_inline_members = 0;
+  tp_clear_pointer (&priv->members_table, g_hash_table_unref);
+  tp_clear_pointer (&priv->members_cache, g_hash_table_unref);
+
+  tp_clear_pointer (&priv->member_changes, g_hash_table_unref);
+  tp_clear_pointer (&priv->member_removals, g_hash_table_unref);
 
   if (G_OBJECT_CLASS (tpy_base_call_channel_parent_class)->dispose)
     G_OBJECT_CLASS (tpy_base_call_channel_parent_class)->dispose (object);
@@ -512,8 +700,7 @@ tpy_base_call_channel_finalize (GObject *object)
   TpyBaseCallChannel *self = TPY_BASE_CALL_CHANNEL (object);
   TpyBaseCallChannelPrivate *priv = self->priv;
 
-  g_hash_table_unref (priv->details);
-  g_value_array_free (priv->reason);
+  g_hash_table_unref (priv->content_links);
   g_free (self->priv->initial_audio_name);
   g_free (self->priv->initial_video_name);
   tp_clear_pointer (&self->priv->deferred_tones, g_free);
@@ -538,7 +725,7 @@ tpy_base_call_channel_set_state (TpyBaseCallChannel *self,
 
   if (tp_base_channel_is_registered (TP_BASE_CHANNEL (self)))
     tpy_svc_channel_type_call_emit_call_state_changed (self, priv->state,
-      priv->flags, priv->reason, priv->details);
+      priv->flags, get_state_reason (), get_state_details ());
 }
 
 TpyCallState
@@ -554,36 +741,30 @@ tpy_base_call_channel_remove_content (TpyBaseCallChannel *self,
   TpyBaseCallChannelPrivate *priv = self->priv;
   const gchar *path;
   GList *l;
-  gboolean still_have_audio = FALSE;
+  TpMediaStreamType mtype;
 
-  priv->contents = g_list_remove (priv->contents, content);
+  path = tpy_base_call_content_get_object_path (content);
+  l = g_hash_table_lookup (priv->content_links, path);
+  g_return_if_fail (l != NULL);
 
-  path = tpy_base_call_content_get_object_path (
-      TPY_BASE_CALL_CONTENT (content));
-  tpy_svc_channel_type_call_emit_content_removed (self, path);
+  g_hash_table_remove (priv->content_links, path);
+  priv->contents = g_list_delete_link (priv->contents, l);
+  tp_clear_pointer (&priv->content_paths, g_ptr_array_unref);
 
-  tpy_base_call_content_deinit (TPY_BASE_CALL_CONTENT (content));
-  g_object_unref (content);
+  mtype = tpy_base_call_content_get_media_type (content);
+  priv->n_contents[mtype]--;
 
-  /* let's see if we still have any audio contents */
-  for (l = priv->contents; l != NULL; l = l->next)
-    {
-      if (tpy_base_call_content_get_media_type (
-              TPY_BASE_CALL_CONTENT (l->data)) ==
-          TP_MEDIA_STREAM_TYPE_AUDIO)
-        {
-          still_have_audio = TRUE;
-          break;
-        }
-    }
+  tpy_svc_channel_type_call_emit_content_removed (self, path);
 
-  if (priv->have_some_audio && !still_have_audio)
+  if (mtype == TP_MEDIA_STREAM_TYPE_AUDIO && !have_some_audio (self))
     {
       /* the last audio stream just closed */
-      tp_dtmf_player_cancel (priv->dtmf_player);
+      if (priv->dtmf_player != NULL)
+        tp_dtmf_player_cancel (priv->dtmf_player);
     }
 
-  priv->have_some_audio = still_have_audio;
+  tpy_base_call_content_deinit (content);
+  g_object_unref (content);
 }
 
 void
@@ -591,34 +772,34 @@ tpy_base_call_channel_add_content (TpyBaseCallChannel *self,
     TpyBaseCallContent *content)
 {
   TpyBaseCallChannelPrivate *priv = self->priv;
+  const gchar *path = tpy_base_call_content_get_object_path (content);
+  TpMediaStreamType mtype = tpy_base_call_content_get_media_type (content);
+
+  g_return_if_fail (mtype < NUM_TP_MEDIA_STREAM_TYPES);
+  g_return_if_fail (g_hash_table_lookup (priv->content_links, path) == NULL);
 
   g_signal_connect_swapped (content, "removed",
       G_CALLBACK (tpy_base_call_channel_remove_content), self);
 
   priv->contents = g_list_prepend (priv->contents, content);
+  g_hash_table_insert (priv->content_links, (gpointer) path, priv->contents);
+  tp_clear_pointer (&priv->content_paths, g_ptr_array_unref);
 
-  if (tpy_base_call_content_get_media_type (content)
-      == TP_MEDIA_STREAM_TYPE_AUDIO)
-    priv->have_some_audio = TRUE;
+  priv->n_contents[mtype]++;
 
-  tpy_svc_channel_type_call_emit_content_added (self,
-     tpy_base_call_content_get_object_path (content));
+  tpy_svc_channel_type_call_emit_content_added (self, path);
 }
 
 static void
 tpy_base_call_channel_close (TpBaseChannel *base)
 {
   TpyBaseCallChannel *self = TPY_BASE_CALL_CHANNEL (base);
-  TpyBaseCallChannelPrivate *priv = self->priv;
 
   /* FIXME de-init members */
   DEBUG ("Closing media channel %s", tp_base_channel_get_object_path (base));
 
   /* shutdown all our contents */
-  g_list_foreach (priv->contents, (GFunc) tpy_base_call_content_deinit,
-      NULL);
-  g_list_foreach (priv->contents, (GFunc) g_object_unref, NULL);
-  tp_clear_pointer (&priv->contents, g_list_free);
+  clear_contents (self);
 
   tp_base_channel_destroyed (base);
 }
@@ -807,7 +988,7 @@ tpy_base_call_channel_start_tone (TpSvcChannelInterfaceDTMF *iface,
   gchar tones[2] = { '\0', '\0' };
   GError *error = NULL;
 
-  if (!self->priv->have_some_audio)
+  if (!have_some_audio (self))
     {
       GError e = { TP_ERROR, TP_ERROR_NOT_AVAILABLE,
           "There are no audio streams" };
@@ -818,7 +999,7 @@ tpy_base_call_channel_start_tone (TpSvcChannelInterfaceDTMF *iface,
 
   tones[0] = tp_dtmf_event_to_char (event);
 
-  if (tp_dtmf_player_play (self->priv->dtmf_player,
+  if (tp_dtmf_player_play (get_dtmf_player (self),
       tones, MAX_TONE_SECONDS * 1000, GAP_MS, PAUSE_MS, &error))
     {
       tp_clear_pointer (&self->priv->deferred_tones, g_free);
@@ -839,7 +1020,9 @@ tpy_base_call_channel_stop_tone (TpSvcChannelInterfaceDTMF *iface,
 {
   TpyBaseCallChannel *self = TPY_BASE_CALL_CHANNEL (iface);
 
-  tp_dtmf_player_cancel (self->priv->dtmf_player);
+  if (self->priv->dtmf_player != NULL)
+    tp_dtmf_player_cancel (self->priv->dtmf_player);
+
   tp_svc_channel_interface_dtmf_return_from_stop_tone (context);
 }
 
@@ -852,7 +1035,7 @@ tpy_base_call_channel_multiple_tones (
   TpyBaseCallChannel *self = TPY_BASE_CALL_CHANNEL (iface);
   GError *error = NULL;
 
-  if (!self->priv->have_some_audio)
+  if (!have_some_audio (self))
     {
       GError e = { TP_ERROR, TP_ERROR_NOT_AVAILABLE,
           "There are no audio streams" };
@@ -861,7 +1044,7 @@ tpy_base_call_channel_multiple_tones (
       return;
     }
 
-  if (tp_dtmf_player_play (self->priv->dtmf_player,
+  if (tp_dtmf_player_play (get_dtmf_player (self),
       dialstring, TONE_MS, GAP_MS, PAUSE_MS, &error))
     {
       tp_clear_pointer (&self->priv->deferred_tones, g_free);
@@ -889,18 +1072,111 @@ dtmf_iface_init (gpointer g_iface, gpointer iface_data)
 }
 
 static void
-base_call_channel_signal_call_members (TpyBaseCallChannel *self,
-  TpHandle removed_handle)
+base_call_channel_flush_member_changes (TpyBaseCallChannel *self)
 {
-  GArray *removals = g_array_new (TRUE, TRUE, sizeof (TpHandle));
+  TpyBaseCallChannelPrivate *priv = self->priv;
+  GArray *removals;
+  GHashTableIter iter;
+  gpointer key;
 
-  if (removed_handle != 0)
-    g_array_append_val (removals, removed_handle);
+  if (priv->member_changes == NULL ||
+      (g_hash_table_size (priv->member_changes) == 0 &&
+       g_hash_table_size (priv->member_removals) == 0))
+    return;
+
+  removals = g_array_sized_new (TRUE, TRUE, sizeof (TpHandle),
+      g_hash_table_size (priv->member_removals));
+
+  g_hash_table_iter_init (&iter, priv->member_removals);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+      TpHandle handle = GPOINTER_TO_UINT (key);
+
+      g_array_append_val (removals, handle);
+    }
+
+  DEBUG ("%u member(s) changed, %u removed",
+      g_hash_table_size (priv->member_changes), removals->len);
 
   tpy_svc_channel_type_call_emit_call_members_changed (self,
-      self->priv->call_members, removals);
+      priv->member_changes, removals);
 
   g_array_unref (removals);
+  g_hash_table_remove_all (priv->member_changes);
+  g_hash_table_remove_all (priv->member_removals);
+}
+
+static gboolean
+base_call_channel_flush_member_changes_idle (gpointer user_data)
+{
+  TpyBaseCallChannel *self = TPY_BASE_CALL_CHANNEL (user_data);
+
+  self->priv->member_changes_idle_id = 0;
+
+  if (self->priv->member_batch_depth == 0)
+    base_call_channel_flush_member_changes (self);
+
+  return FALSE;
+}
+
+/* Signals a member change. Outside batches and coalescing, CallMembersChanged
+ * carries every member, as it always has; otherwise the change is recorded
+ * and only the members that changed are signalled when it is flushed. */
+static void
+base_call_channel_member_changed (TpyBaseCallChannel *self,
+    TpHandle handle,
+    TpyCallMemberFlags flags,
+    gboolean removed)
+{
+  TpyBaseCallChannelPrivate *priv = self->priv;
+
+  if (priv->members_cache != NULL)
+    {
+      if (removed)
+        g_hash_table_remove (priv->members_cache, GUINT_TO_POINTER (handle));
+      else
+        g_hash_table_insert (priv->members_cache, GUINT_TO_POINTER (handle),
+            GUINT_TO_POINTER (flags));
+    }
+
+  if (priv->member_batch_depth == 0 && !priv->coalesce_member_changes)
+    {
+      GArray *removals = g_array_sized_new (TRUE, TRUE, sizeof (TpHandle),
+          1);
+
+      if (removed)
+        g_array_append_val (removals, handle);
+
+      tpy_svc_channel_type_call_emit_call_members_changed (self,
+          get_members (self), removals);
+
+      g_array_unref (removals);
+      return;
+    }
+
+  if (priv->member_changes == NULL)
+    {
+      priv->member_changes = g_hash_table_new (g_direct_hash, g_direct_equal);
+      priv->member_removals = g_hash_table_new (g_direct_hash,
+          g_direct_equal);
+    }
+
+  if (removed)
+    {
+      g_hash_table_remove (priv->member_changes, GUINT_TO_POINTER (handle));
+      g_hash_table_insert (priv->member_removals, GUINT_TO_POINTER (handle),
+          NULL);
+    }
+  else
+    {
+      g_hash_table_remove (priv->member_removals, GUINT_TO_POINTER (handle));
+      g_hash_table_insert (priv->member_changes, GUINT_TO_POINTER (handle),
+          GUINT_TO_POINTER (flags));
+    }
+
+  if (priv->member_batch_depth == 0 && priv->member_changes_idle_id == 0)
+    priv->member_changes_idle_id = g_idle_add (
+        base_call_channel_flush_member_changes_idle, self);
 }
 
 void
@@ -912,12 +1188,38 @@ tpy_base_call_channel_add_member (TpyBaseCallChannel *self,
 
   DEBUG ("Member %d (flags: %d) added", handle, initial_flags);
 
-  g_assert (!g_hash_table_lookup_extended (priv->call_members,
-    GUINT_TO_POINTER (handle), NULL, NULL));
+  g_assert (!has_member (self, handle));
+
+  if (priv->members_table == NULL &&
+      priv->n_inline_members < N_INLINE_MEMBERS)
+    {
+      priv->inline_members[priv->n_inline_members].handle = handle;
+      priv->inline_members[priv->n_inline_members].flags = initial_flags;
+      priv->n_inline_members++;
+    }
+  else
+    {
+      if (priv->members_table == NULL)
+        {
+          guint i;
+
+          priv->members_table = g_hash_table_new (g_direct_hash,
+              g_direct_equal);
+          tp_clear_pointer (&priv->members_cache, g_hash_table_unref);
+
+          for (i = 0; i < priv->n_inline_members; i++)
+            g_hash_table_insert (priv->members_table,
+                GUINT_TO_POINTER (priv->inline_members[i].handle),
+                GUINT_TO_POINTER (priv->inline_members[i].flags));
 
-  g_hash_table_insert (priv->call_members,
-    GUINT_TO_POINTER (handle), GUINT_TO_POINTER (initial_flags));
-  base_call_channel_signal_call_members (self, 0);
+          priv->n_inline_members = 0;
+        }
+
+      g_hash_table_insert (priv->members_table, GUINT_TO_POINTER (handle),
+          GUINT_TO_POINTER (initial_flags));
+    }
+
+  base_call_channel_member_changed (self, handle, initial_flags, FALSE);
 }
 
 void tpy_base_call_channel_update_member_flags (TpyBaseCallChannel *self,
@@ -928,22 +1230,124 @@ void tpy_base_call_channel_update_member_flags (TpyBaseCallChannel *self,
 
   DEBUG ("Member %d (flags: %d) updated", handle, flags);
 
-  g_assert (g_hash_table_lookup_extended (priv->call_members,
-    GUINT_TO_POINTER (handle), NULL, NULL));
+  g_assert (has_member (self, handle));
+
+  if (priv->members_table != NULL)
+    g_hash_table_insert (priv->members_table, GUINT_TO_POINTER (handle),
+        GUINT_TO_POINTER (flags));
+  else
+    find_inline_member (self, handle)->flags = flags;
 
-  g_hash_table_replace (priv->call_members,
-    GUINT_TO_POINTER (handle), GUINT_TO_POINTER (flags));
-  base_call_channel_signal_call_members (self, 0);
+  base_call_channel_member_changed (self, handle, flags, FALSE);
 }
 
 void
 tpy_base_call_channel_remove_member (TpyBaseCallChannel *self,
     TpHandle handle)
 {
+  TpyBaseCallChannelPrivate *priv = self->priv;
+
   DEBUG ("Member %d removed", handle);
 
-  g_hash_table_remove (self->priv->call_members, GUINT_TO_POINTER (handle));
-  base_call_channel_signal_call_members (self, handle);
+  if (priv->members_table != NULL)
+    {
+      g_hash_table_remove (priv->members_table, GUINT_TO_POINTER (handle));
+    }
+  else
+    {
+      CallMember *member = find_inline_member (self, handle);
+
+      /* order doesn't matter, so fill the gap with the last member */
+      if (member != NULL)
+        *member = priv->inline_members[--priv->n_inline_members];
+    }
+
+  base_call_channel_member_changed (self, handle, 0, TRUE);
+}
+
+/**
+ * tpy_base_call_channel_begin_member_changes:
+ * @self: a #TpyBaseCallChannel
+ *
+ * Starts a batch of member changes. Until the matching
+ * tpy_base_call_channel_commit_member_changes() call, adding, updating and
+ * removing members does not emit CallMembersChanged. Batches may be nested.
+ */
+void
+tpy_base_call_channel_begin_member_changes (TpyBaseCallChannel *self)
+{
+  g_return_if_fail (TPY_IS_BASE_CALL_CHANNEL (self));
+
+  self->priv->member_batch_depth++;
+}
+
+/**
+ * tpy_base_call_channel_commit_member_changes:
+ * @self: a #TpyBaseCallChannel
+ *
+ * Ends a batch started with tpy_base_call_channel_begin_member_changes().
+ * When the outermost batch ends, a single CallMembersChanged is emitted
+ * containing only the members whose flags changed during the batch, and
+ * the members that were removed.
+ */
+void
+tpy_base_call_channel_commit_member_changes (TpyBaseCallChannel *self)
+{
+  TpyBaseCallChannelPrivate *priv;
+
+  g_return_if_fail (TPY_IS_BASE_CALL_CHANNEL (self));
+
+  priv = self->priv;
+  g_return_if_fail (priv->member_batch_depth > 0);
+
+  if (--priv->member_batch_depth > 0)
+    return;
+
+  if (priv->member_changes_idle_id != 0)
+    {
+      g_source_remove (priv->member_changes_idle_id);
+      priv->member_changes_idle_id = 0;
+    }
+
+  base_call_channel_flush_member_changes (self);
+}
+
+/**
+ * tpy_base_call_channel_set_coalesce_member_changes:
+ * @self: a #TpyBaseCallChannel
+ * @coalesce: whether to coalesce member changes
+ *
+ * If @coalesce is %TRUE, member changes are collected until the main loop
+ * is next idle and then signalled as a single CallMembersChanged carrying
+ * only what changed. Turning coalescing off flushes any pending changes.
+ */
+void
+tpy_base_call_channel_set_coalesce_member_changes (TpyBaseCallChannel *self,
+    gboolean coalesce)
+{
+  TpyBaseCallChannelPrivate *priv;
+
+  g_return_if_fail (TPY_IS_BASE_CALL_CHANNEL (self));
+
+  priv = self->priv;
+
+  if (priv->coalesce_member_changes == coalesce)
+    return;
+
+  priv->coalesce_member_changes = coalesce;
+
+  if (!coalesce && priv->member_batch_depth == 0)
+    {
+      if (priv->member_changes_idle_id != 0)
+        {
+          g_source_remove (priv->member_changes_idle_id);
+          priv->member_changes_idle_id = 0;
+        }
+
+      base_call_channel_flush_member_changes (self);
+    }
+
+  g_object_notify (G_OBJECT (self), "coalesce-member-changes");
 }
 
 GList *
@@ -103,6 +103,12 @@ void tpy_base_call_channel_add_member (TpyBaseCallChannel *self,
 void tpy_base_call_channel_remove_member (TpyBaseCallChannel *self,
     TpHandle handle);
 
+void tpy_base_call_channel_begin_member_changes (TpyBaseCallChannel *self);
+void tpy_base_call_channel_commit_member_changes (TpyBaseCallChannel *self);
+void tpy_base_call_channel_set_coalesce_member_changes (
+    TpyBaseCallChannel *self,
+    gboolean coalesce);
+
 G_END_DECLS
 
 #endif /* #ifndef __TPY_BASE_CALL_CHANNEL_H__*/
@@ -54,6 +54,9 @@ struct _TpyBaseCallContentPrivate
   TpyCallContentDisposition disposition;
 
   GList *streams;
+  /* Streams property; borrowed paths, NULL until needed again after the
+   * set of streams changes */
+  GPtrArray *stream_paths;
 
   gboolean dispose_has_run;
   gboolean deinit_has_run;
@@ -98,6 +101,24 @@ tpy_base_call_content_constructed (GObject *obj)
   tp_dbus_daemon_register_object (priv->dbus_daemon, priv->object_path, obj);
 }
 
+static GPtrArray *
+get_stream_paths (TpyBaseCallContent *self)
+{
+  TpyBaseCallContentPrivate *priv = self->priv;
+  GList *l;
+
+  if (priv->stream_paths != NULL)
+    return priv->stream_paths;
+
+  priv->stream_paths = g_ptr_array_sized_new (g_list_length (priv->streams));
+
+  for (l = priv->streams; l != NULL; l = g_list_next (l))
+    g_ptr_array_add (priv->stream_paths, (gpointer)
+        tpy_base_call_stream_get_object_path (TPY_BASE_CALL_STREAM (l->data)));
+
+  return priv->stream_paths;
+}
+
 static void
 tpy_base_call_content_dispose (GObject *object)
 {
@@ -110,6 +131,8 @@ tpy_base_call_content_dispose (GObject *object)
 
   priv->dispose_has_run = TRUE;
 
+  tp_clear_pointer (&priv->stream_paths, g_ptr_array_unref);
+
   for (l = priv->streams; l != NULL; l = g_list_next (l))
     g_object_unref (l->data);
 
@@ -156,15 +179,16 @@ tpy_base_call_content_get_property (
           TpyBaseCallContentClass *klass =
               TPY_BASE_CALL_CONTENT_GET_CLASS (content);
 
+          /* both live as long as the class */
           if (klass->extra_interfaces != NULL)
             {
-              g_value_set_boxed (value, klass->extra_interfaces);
+              g_value_set_static_boxed (value, klass->extra_interfaces);
             }
           else
             {
               static gchar *empty[] = { NULL };
 
-              g_value_set_boxed (value, empty);
+              g_value_set_static_boxed (value, empty);
             }
           break;
         }
@@ -181,26 +205,28 @@ tpy_base_call_content_get_property (
         g_value_set_uint (value, priv->disposition);
         break;
       case PROP_STREAMS:
-        {
-          GPtrArray *arr = g_ptr_array_sized_new (2);
-          GList *l;
-
-          for (l = priv->streams; l != NULL; l = g_list_next (l))
-            {
-              TpyBaseCallStream *s = TPY_BASE_CALL_STREAM (l->data);
-              g_ptr_array_add (arr,
-                  g_strdup (tpy_base_call_stream_get_object_path (s)));
-            }
-
-          g_value_take_boxed (value, arr);
-          break;
-        }
+        /* the cached array lives until the set of streams changes */
+        g_value_set_static_boxed (value, get_stream_paths (content));
+        break;
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
         break;
     }
 }
 
+/* The D-Bus property tables hold property IDs rather than names, so that
+ * reading them doesn't have to look up the GParamSpec first */
+static void
+tpy_base_call_content_get_dbus_property (GObject *object,
+    GQuark iface,
+    GQuark name,
+    GValue *value,
+    gpointer getter_data)
+{
+  tpy_base_call_content_get_property (object, GPOINTER_TO_UINT (getter_data),
+      value, NULL);
+}
+
 static void
 tpy_base_call_content_set_property (
     GObject *object,
@@ -245,16 +271,16 @@ tpy_base_call_content_class_init (
   GObjectClass *object_class = G_OBJECT_CLASS (bcc_class);
   GParamSpec *param_spec;
   static TpDBusPropertiesMixinPropImpl content_props[] = {
-    { "Interfaces", "interfaces", NULL },
-    { "Name", "name", NULL },
-    { "Type", "media-type", NULL },
-    { "Disposition", "disposition", NULL },
-    { "Streams", "streams", NULL },
+    { "Interfaces", GUINT_TO_POINTER (PROP_INTERFACES), NULL },
+    { "Name", GUINT_TO_POINTER (PROP_NAME), NULL },
+    { "Type", GUINT_TO_POINTER (PROP_MEDIA_TYPE), NULL },
+    { "Disposition", GUINT_TO_POINTER (PROP_DISPOSITION), NULL },
+    { "Streams", GUINT_TO_POINTER (PROP_STREAMS), NULL },
     { NULL }
   };
   static TpDBusPropertiesMixinIfaceImpl prop_interfaces[] = {
       { TPY_IFACE_CALL_CONTENT,
-        tp_dbus_properties_mixin_getter_gobject_properties,
+        tpy_base_call_content_get_dbus_property,
         NULL,
         content_props,
       },
@@ -385,6 +411,7 @@ tpy_base_call_content_add_stream (TpyBaseCallContent *self,
 
   self->priv->streams = g_list_prepend (self->priv->streams,
       g_object_ref (stream));
+  tp_clear_pointer (&self->priv->stream_paths, g_ptr_array_unref);
 
   paths = g_ptr_array_new_with_free_func ((GDestroyNotify) g_free);
 
@@ -410,7 +437,8 @@ tpy_base_call_content_remove_stream (TpyBaseCallContent *self,
   l = g_list_find (priv->streams, stream);
   g_return_if_fail (l != NULL);
 
-  priv->streams = g_list_remove_link (priv->streams, l);
+  priv->streams = g_list_delete_link (priv->streams, l);
+  tp_clear_pointer (&priv->stream_paths, g_ptr_array_unref);
   paths = g_ptr_array_new_with_free_func ((GDestroyNotify) g_free);
   g_ptr_array_add (paths, g_strdup (
      tpy_base_call_stream_get_object_path (
@@ -433,6 +461,7 @@ base_call_content_deinit_real (TpyBaseCallContent *self)
   tp_dbus_daemon_unregister_object (priv->dbus_daemon, G_OBJECT (self));
   tp_clear_object (&priv->dbus_daemon);
 
+  tp_clear_pointer (&priv->stream_paths, g_ptr_array_unref);
   g_list_foreach (priv->streams, (GFunc) g_object_unref, NULL);
   tp_clear_pointer (&priv->streams, g_list_free);
 }
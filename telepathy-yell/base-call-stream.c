@@ -24,6 +24,7 @@
 #define DEBUG_FLAG TPY_DEBUG_CALL
 #include "debug.h"
 
+#include <telepathy-yell/extensions.h>
 #include <telepathy-yell/interfaces.h>
 #include <telepathy-yell/gtypes.h>
 #include <telepathy-yell/svc-call.h>
@@ -58,6 +59,11 @@ struct _TpyBaseCallStreamPrivate
 
   GHashTable *remote_members;
 
+  /* Reused for every RemoteMembersChanged we emit; always empty between
+   * emissions */
+  GHashTable *updates_scratch;
+  GArray *removals_scratch;
+
   TpySendingState local_sending_state;
 };
 
@@ -69,6 +75,8 @@ tpy_base_call_stream_init (TpyBaseCallStream *self)
 
   self->priv = priv;
   priv->remote_members = g_hash_table_new (g_direct_hash, g_direct_equal);
+  priv->updates_scratch = g_hash_table_new (g_direct_hash, g_direct_equal);
+  priv->removals_scratch = g_array_new (FALSE, TRUE, sizeof (TpHandle));
 }
 
 static void
@@ -116,6 +124,8 @@ tpy_base_call_stream_finalize (GObject *object)
   /* free any data held directly by the object here */
   g_free (priv->object_path);
   g_hash_table_destroy (priv->remote_members);
+  g_hash_table_destroy (priv->updates_scratch);
+  g_array_free (priv->removals_scratch, TRUE);
 
   if (G_OBJECT_CLASS (tpy_base_call_stream_parent_class)->finalize != NULL)
     G_OBJECT_CLASS (tpy_base_call_stream_parent_class)->finalize (object);
@@ -158,15 +168,16 @@ tpy_base_call_stream_get_property (
           TpyBaseCallStreamClass *klass =
               TPY_BASE_CALL_STREAM_GET_CLASS (self);
 
+          /* both live as long as the class */
           if (klass->extra_interfaces != NULL)
             {
-              g_value_set_boxed (value, klass->extra_interfaces);
+              g_value_set_static_boxed (value, klass->extra_interfaces);
             }
           else
             {
-              gchar *empty[] = { NULL };
+              static gchar *empty[] = { NULL };
 
-              g_value_set_boxed (value, empty);
+              g_value_set_static_boxed (value, empty);
             }
           break;
         }
@@ -176,6 +187,19 @@ tpy_base_call_stream_get_property (
     }
 }
 
+/* stream_props holds property IDs, which are passed straight to
+ * get_property */
+static void
+tpy_base_call_stream_get_dbus_property (GObject *object,
+    GQuark iface,
+    GQuark name,
+    GValue *value,
+    gpointer getter_data)
+{
+  tpy_base_call_stream_get_property (object, GPOINTER_TO_UINT (getter_data),
+      value, NULL);
+}
+
 static void
 tpy_base_call_stream_set_property (
     GObject *object,
@@ -211,15 +235,17 @@ tpy_base_call_stream_class_init (TpyBaseCallStreamClass *bsc_class)
   GObjectClass *object_class = G_OBJECT_CLASS (bsc_class);
   GParamSpec *param_spec;
   static TpDBusPropertiesMixinPropImpl stream_props[] = {
-    { "Interfaces", "interfaces", NULL },
-    { "RemoteMembers", "remote-members", NULL },
-    { "LocalSendingState", "local-sending-state", NULL },
-    { "CanRequestReceiving", "can-request-receiving", NULL },
+    { "Interfaces", GUINT_TO_POINTER (PROP_INTERFACES), NULL },
+    { "RemoteMembers", GUINT_TO_POINTER (PROP_REMOTE_MEMBERS), NULL },
+    { "LocalSendingState", GUINT_TO_POINTER (PROP_LOCAL_SENDING_STATE),
+      NULL },
+    { "CanRequestReceiving", GUINT_TO_POINTER (PROP_CAN_REQUEST_RECEIVING),
+      NULL },
     { NULL }
   };
   static TpDBusPropertiesMixinIfaceImpl prop_interfaces[] = {
       { TPY_IFACE_CALL_STREAM,
-        tp_dbus_properties_mixin_getter_gobject_properties,
+        tpy_base_call_stream_get_dbus_property,
         NULL,
         stream_props,
       },
@@ -325,13 +351,51 @@ _remote_member_update_state (TpyBaseCallStream *self,
   return TRUE;
 }
 
+static gboolean
+_remote_member_remove (TpyBaseCallStream *self,
+    TpHandle contact)
+{
+  TpyBaseCallStreamPrivate *priv = self->priv;
+
+  if (!g_hash_table_remove (priv->remote_members, GUINT_TO_POINTER (contact)))
+    return FALSE;
+
+  DEBUG ("Removing remote member %d", contact);
+
+  g_hash_table_remove (priv->updates_scratch, GUINT_TO_POINTER (contact));
+  g_array_append_val (priv->removals_scratch, contact);
+
+  return TRUE;
+}
+
+/* Emits whatever has been collected in the scratch containers, if anything,
+ * and empties them again. */
+static gboolean
+_remote_members_flush (TpyBaseCallStream *self)
+{
+  TpyBaseCallStreamPrivate *priv = self->priv;
+
+  if (g_hash_table_size (priv->updates_scratch) == 0 &&
+      priv->removals_scratch->len == 0)
+    return FALSE;
+
+  tpy_svc_call_stream_emit_remote_members_changed (self,
+      priv->updates_scratch, priv->removals_scratch);
+  tpy_dbus_properties_queue_changed (G_OBJECT (self),
+      TPY_IFACE_CALL_STREAM, "RemoteMembers");
+
+  g_hash_table_remove_all (priv->updates_scratch);
+  g_array_set_size (priv->removals_scratch, 0);
+
+  return TRUE;
+}
+
 gboolean
 tpy_base_call_stream_update_remote_member_states (TpyBaseCallStream *self,
       TpHandle peer, TpySendingState remote_state,
       ...)
 {
-  GHashTable *updates = g_hash_table_new (g_direct_hash, g_direct_equal);
-  gboolean updated = FALSE;
+  TpyBaseCallStreamPrivate *priv = self->priv;
   va_list args;
 
   va_start (args, remote_state);
@@ -339,12 +403,9 @@ tpy_base_call_stream_update_remote_member_states (TpyBaseCallStream *self,
   do
     {
       if (_remote_member_update_state (self, peer, remote_state))
-        {
-          g_hash_table_insert (updates,
-              GUINT_TO_POINTER (peer),
-              GUINT_TO_POINTER (remote_state));
-          updated = TRUE;
-        }
+        g_hash_table_insert (priv->updates_scratch,
+            GUINT_TO_POINTER (peer),
+            GUINT_TO_POINTER (remote_state));
 
       peer = va_arg (args, TpHandle);
       if (peer != 0)
@@ -352,38 +413,67 @@ tpy_base_call_stream_update_remote_member_states (TpyBaseCallStream *self,
     }
   while (peer != 0);
 
-  if (updated)
+  va_end (args);
+
+  return _remote_members_flush (self);
+}
+
+/**
+ * tpy_base_call_stream_update_remote_members:
+ * @self: a #TpyBaseCallStream
+ * @updates: (allow-none): a map from contact handle to #TpySendingState
+ * @removed: (allow-none): an array of contact handles that left the stream
+ *
+ * Applies many remote member changes at once, and emits a single
+ * RemoteMembersChanged listing only the members whose state actually
+ * changed and the members that were actually removed. A handle which is
+ * both updated and removed ends up removed.
+ *
+ * Returns: %TRUE if anything changed
+ */
+gboolean
+tpy_base_call_stream_update_remote_members (TpyBaseCallStream *self,
+    GHashTable *updates,
+    const GArray *removed)
+{
+  TpyBaseCallStreamPrivate *priv;
+  guint i;
+
+  g_return_val_if_fail (TPY_IS_BASE_CALL_STREAM (self), FALSE);
+
+  priv = self->priv;
+
+  if (updates != NULL)
     {
-      GArray *empty = g_array_new (FALSE, TRUE, sizeof (TpHandle));
+      GHashTableIter iter;
+      gpointer key, value;
+
+      g_hash_table_iter_init (&iter, updates);
+      while (g_hash_table_iter_next (&iter, &key, &value))
+        {
+          if (_remote_member_update_state (self, GPOINTER_TO_UINT (key),
+                  GPOINTER_TO_UINT (value)))
+            g_hash_table_insert (priv->updates_scratch, key, value);
+        }
+    }
 
-      tpy_svc_call_stream_emit_remote_members_changed (self, updates, empty);
-      g_array_unref (empty);
+  if (removed != NULL)
+    {
+      for (i = 0; i < removed->len; i++)
+        _remote_member_remove (self, g_array_index (removed, TpHandle, i));
     }
 
-  g_hash_table_unref (updates);
-  return updated;
+  return _remote_members_flush (self);
 }
 
 gboolean
 tpy_base_call_stream_remove_member (TpyBaseCallStream *self,
     TpHandle removed)
 {
-  GArray *removed_array;
-  GHashTable *empty;
-
-  if (!g_hash_table_remove (self->priv->remote_members,
-      GUINT_TO_POINTER(removed)))
+  if (!_remote_member_remove (self, removed))
     return FALSE;
 
-  empty= g_hash_table_new (g_direct_hash, g_direct_equal);
-  removed_array = g_array_sized_new (FALSE, TRUE, sizeof (TpHandle), 1);
-  g_array_append_val (removed_array, removed);
-
-  tpy_svc_call_stream_emit_remote_members_changed (self, empty, removed_array);
-
-  g_hash_table_unref (empty);
-  g_array_free (removed_array, TRUE);
-  return TRUE;
+  return _remote_members_flush (self);
 }
 
 TpySendingState
@@ -407,6 +497,8 @@ tpy_base_call_stream_update_local_sending_state (TpyBaseCallStream *self,
 
   tpy_svc_call_stream_emit_local_sending_state_changed (
     TPY_SVC_CALL_STREAM (self), state);
+  tpy_dbus_properties_queue_changed (G_OBJECT (self),
+      TPY_IFACE_CALL_STREAM, "LocalSendingState");
 
   return TRUE;
 }
@@ -105,6 +105,11 @@ gboolean tpy_base_call_stream_remove_member (
     TpyBaseCallStream *self,
     TpHandle removed);
 
+gboolean tpy_base_call_stream_update_remote_members (
+    TpyBaseCallStream *self,
+    GHashTable *updates,
+    const GArray *removed);
+
 gboolean tpy_base_call_stream_set_sending (TpyBaseCallStream *self,
     gboolean send, GError **error);
 
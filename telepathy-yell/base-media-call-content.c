@@ -20,12 +20,14 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <telepathy-glib/base-connection.h>
 #include <telepathy-glib/dbus.h>
 #include <telepathy-glib/svc-properties-interface.h>
 #include <telepathy-glib/base-connection.h>
 #include <telepathy-glib/gtypes.h>
+#include <telepathy-glib/util.h>
 
 #include <telepathy-yell/gtypes.h>
 #include <telepathy-yell/interfaces.h>
@@ -37,10 +39,19 @@
 
 #include "debug.h"
 
+/* Finished offers made by tpy_base_media_call_content_offer_codecs() are kept
+ * for reuse, up to this many per content */
+#define MAX_POOLED_OFFERS 4
+
+/* Default size of each content's negotiation cache */
+#define DEFAULT_NEGOTIATION_CACHE_SIZE 16
+
 static void call_content_media_iface_init (gpointer, gpointer);
 static void call_content_deinit (TpyBaseCallContent *base);
+static void tpy_base_media_call_codec_list_release (gpointer codecs);
 static void tpy_base_media_call_content_next_offer (
-    TpyBaseMediaCallContent *self);
+    TpyBaseMediaCallContent *self,
+    guint lane_key);
 
 G_DEFINE_TYPE_WITH_CODE(TpyBaseMediaCallContent, tpy_base_media_call_content,
     TPY_TYPE_BASE_CALL_CONTENT,
@@ -55,6 +66,11 @@ enum
   PROP_PACKETIZATION,
 
   PROP_CODEC_OFFER,
+  PROP_PARALLEL_OFFERS,
+  PROP_COALESCE_CODEC_CHANGES,
+  PROP_NEGOTIATION_CACHE,
+  PROP_OFFER_TIMEOUT,
+  PROP_OFFER_TIMEOUTS,
 };
 
 /* signal enum */
@@ -66,21 +82,56 @@ enum
 
 static guint signals[LAST_SIGNAL] = {0};
 
+/* Offers in a lane are made one at a time, in order. Without parallel-offers
+ * there is a single lane (0); with it, each remote contact has its own lane
+ * keyed by its handle. */
+typedef struct {
+    TpyCallContentCodecOffer *current;
+    /* owned by current, which drops it once it's finished */
+    GCancellable *cancellable;
+    /* interned local codecs when current was offered, or NULL */
+    GPtrArray *capabilities;
+    /* gives up on current once offer-timeout has passed */
+    guint timeout_id;
+    GQueue pending;
+} OfferLane;
+
 /* private structure */
 struct _TpyBaseMediaCallContentPrivate
 {
   gboolean initial_offer_appeared;
+  /* One of the running offers, as exposed by CodecOffer */
   TpyCallContentCodecOffer *current_offer;
-  GQueue *outstanding_offers;
-  GCancellable *offer_cancellable;
+  /* lane key => OfferLane */
+  GHashTable *offer_lanes;
+  gboolean parallel_offers;
+  /* offers added but not finished yet, queued ones included */
   guint offer_count;
+  /* idle offers of our own, ready to be reset and offered again */
+  GQueue offer_pool;
+  guint pooled_offer_serial;
 
   gboolean dispose_has_run;
   gboolean deinit_has_run;
 
   GHashTable *codec_map;
+  /* Set of contacts whose entry in codec_map changed since CodecsChanged was
+   * last emitted */
+  GHashTable *changed_codecs;
+  gboolean coalesce_codec_changes;
+  guint codecs_changed_idle_id;
+  gboolean negotiation_cache;
+  /* NegotiationCacheEntry => itself; NULL until the first offer finishes
+   * with negotiation_cache set */
+  GHashTable *negotiations;
+  /* Most recently used (or added) entries first */
+  GQueue negotiations_order;
+  /* in milliseconds, 0 for none */
+  guint offer_timeout;
+  guint offer_timeouts;
 
   GPtrArray *local_codecs;
+  guint local_codecs_fingerprint;
 };
 
 static void
@@ -89,6 +140,19 @@ _free_codec_array (gpointer codecs)
   g_boxed_free (TPY_ARRAY_TYPE_CODEC_LIST, codecs);
 }
 
+static void
+offer_lane_free (gpointer data)
+{
+  OfferLane *lane = data;
+
+  g_assert (lane->current == NULL);
+  g_assert (lane->timeout_id == 0);
+
+  g_queue_foreach (&lane->pending, (GFunc) g_object_unref, NULL);
+  g_queue_clear (&lane->pending);
+  g_slice_free (OfferLane, lane);
+}
+
 static void
 tpy_base_media_call_content_init (TpyBaseMediaCallContent *self)
 {
@@ -97,9 +161,13 @@ tpy_base_media_call_content_init (TpyBaseMediaCallContent *self)
 
   self->priv = priv;
 
-  priv->outstanding_offers = g_queue_new ();
+  priv->offer_lanes = g_hash_table_new_full (NULL, NULL, NULL,
+      offer_lane_free);
+  g_queue_init (&priv->offer_pool);
+  g_queue_init (&priv->negotiations_order);
+  priv->changed_codecs = g_hash_table_new (NULL, NULL);
   priv->codec_map = g_hash_table_new_full (g_direct_hash, g_direct_equal,
-      NULL, (GDestroyNotify) _free_codec_array);
+      NULL, tpy_base_media_call_codec_list_release);
 }
 
 static void tpy_base_media_call_content_dispose (GObject *object);
@@ -156,6 +224,106 @@ tpy_base_media_call_content_get_property (GObject    *object,
           g_boxed_free (TPY_ARRAY_TYPE_CODEC_LIST, codecs);
           break;
         }
+      case PROP_PARALLEL_OFFERS:
+        g_value_set_boolean (value, priv->parallel_offers);
+        break;
+      case PROP_COALESCE_CODEC_CHANGES:
+        g_value_set_boolean (value, priv->coalesce_codec_changes);
+        break;
+      case PROP_NEGOTIATION_CACHE:
+        g_value_set_boolean (value, priv->negotiation_cache);
+        break;
+      case PROP_OFFER_TIMEOUT:
+        g_value_set_uint (value, priv->offer_timeout);
+        break;
+      case PROP_OFFER_TIMEOUTS:
+        g_value_set_uint (value, priv->offer_timeouts);
+        break;
+      default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+        break;
+    }
+}
+
+static void
+base_media_call_content_flush_codec_changes (TpyBaseMediaCallContent *self)
+{
+  TpyBaseMediaCallContentPrivate *priv = self->priv;
+  static GArray *no_removals = NULL;
+  GHashTable *updated;
+  GHashTableIter iter;
+  gpointer key, value;
+
+  if (priv->codecs_changed_idle_id != 0)
+    {
+      g_source_remove (priv->codecs_changed_idle_id);
+      priv->codecs_changed_idle_id = 0;
+    }
+
+  if (g_hash_table_size (priv->changed_codecs) == 0)
+    return;
+
+  if (G_UNLIKELY (no_removals == NULL))
+    no_removals = g_array_new (FALSE, FALSE, sizeof (TpHandle));
+
+  /* The codec lists are borrowed from codec_map */
+  updated = g_hash_table_new (NULL, NULL);
+
+  g_hash_table_iter_init (&iter, priv->changed_codecs);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+      value = g_hash_table_lookup (priv->codec_map, key);
+
+      if (value != NULL)
+        g_hash_table_insert (updated, key, value);
+    }
+
+  g_hash_table_remove_all (priv->changed_codecs);
+
+  if (g_hash_table_size (updated) > 0)
+    tpy_svc_call_content_interface_media_emit_codecs_changed (self,
+        updated, no_removals);
+
+  g_hash_table_unref (updated);
+}
+
+static gboolean
+base_media_call_content_flush_codec_changes_idle (gpointer user_data)
+{
+  TpyBaseMediaCallContent *self = user_data;
+
+  self->priv->codecs_changed_idle_id = 0;
+  base_media_call_content_flush_codec_changes (self);
+
+  return FALSE;
+}
+
+static void
+tpy_base_media_call_content_set_property (GObject *object,
+    guint property_id,
+    const GValue *value,
+    GParamSpec *pspec)
+{
+  TpyBaseMediaCallContent *content = TPY_BASE_MEDIA_CALL_CONTENT (object);
+  TpyBaseMediaCallContentPrivate *priv = content->priv;
+
+  switch (property_id)
+    {
+      case PROP_PARALLEL_OFFERS:
+        priv->parallel_offers = g_value_get_boolean (value);
+        break;
+      case PROP_COALESCE_CODEC_CHANGES:
+        priv->coalesce_codec_changes = g_value_get_boolean (value);
+        if (!priv->coalesce_codec_changes)
+          base_media_call_content_flush_codec_changes (content);
+        break;
+      case PROP_NEGOTIATION_CACHE:
+        priv->negotiation_cache = g_value_get_boolean (value);
+        break;
+      case PROP_OFFER_TIMEOUT:
+        /* only applies to offers made from now on */
+        priv->offer_timeout = g_value_get_uint (value);
+        break;
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
         break;
@@ -186,6 +354,7 @@ tpy_base_media_call_content_class_init (
       sizeof (TpyBaseMediaCallContentPrivate));
 
   object_class->get_property = tpy_base_media_call_content_get_property;
+  object_class->set_property = tpy_base_media_call_content_set_property;
   object_class->dispose = tpy_base_media_call_content_dispose;
   object_class->finalize = tpy_base_media_call_content_finalize;
 
@@ -210,6 +379,49 @@ tpy_base_media_call_content_class_init (
   g_object_class_install_property (object_class, PROP_CODEC_OFFER,
       param_spec);
 
+  param_spec = g_param_spec_boolean ("parallel-offers", "Parallel offers",
+      "Whether offers for different contacts may run at the same time",
+      FALSE,
+      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (object_class, PROP_PARALLEL_OFFERS,
+      param_spec);
+
+  param_spec = g_param_spec_boolean ("coalesce-codec-changes",
+      "Coalesce codec changes",
+      "Whether to collect codec changes into one CodecsChanged per main loop "
+      "iteration",
+      FALSE,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (object_class, PROP_COALESCE_CODEC_CHANGES,
+      param_spec);
+
+  param_spec = g_param_spec_boolean ("negotiation-cache", "Negotiation cache",
+      "Whether offers repeating codecs already negotiated with a contact on "
+      "this content may be answered from the earlier result instead of "
+      "going to the streaming implementation",
+      FALSE,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (object_class, PROP_NEGOTIATION_CACHE,
+      param_spec);
+
+  param_spec = g_param_spec_uint ("offer-timeout", "Offer timeout",
+      "How long to wait for a codec offer to be accepted or rejected before "
+      "cancelling it and moving on to the next one, in milliseconds, or 0 to "
+      "wait forever",
+      0, G_MAXUINT, 0,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (object_class, PROP_OFFER_TIMEOUT,
+      param_spec);
+
+  param_spec = g_param_spec_uint ("offer-timeouts", "Offer timeouts",
+      "The number of codec offers cancelled because of offer-timeout",
+      0, G_MAXUINT, 0,
+      G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (object_class, PROP_OFFER_TIMEOUTS,
+      param_spec);
+
+  /* The codec list passed is shared with other contents, and handlers must
+   * not modify it */
   signals[LOCAL_CODECS_UPDATED] = g_signal_new ("local-codecs-updated",
       G_OBJECT_CLASS_TYPE (tpy_base_media_call_content_class),
       G_SIGNAL_RUN_LAST | G_SIGNAL_DETAILED,
@@ -241,6 +453,15 @@ tpy_base_media_call_content_dispose (GObject *object)
 
   g_assert (priv->current_offer == NULL);
 
+  if (priv->codecs_changed_idle_id != 0)
+    {
+      g_source_remove (priv->codecs_changed_idle_id);
+      priv->codecs_changed_idle_id = 0;
+    }
+
+  g_hash_table_unref (priv->changed_codecs);
+  priv->changed_codecs = NULL;
+  tp_clear_pointer (&priv->negotiations, g_hash_table_unref);
   g_hash_table_unref (priv->codec_map);
   priv->local_codecs = NULL;
   priv->codec_map = NULL;
@@ -257,12 +478,56 @@ tpy_base_media_call_content_finalize (GObject *object)
   GObjectClass *object_class =
       G_OBJECT_CLASS (tpy_base_media_call_content_parent_class);
 
-  g_queue_free (priv->outstanding_offers);
+  g_hash_table_unref (priv->offer_lanes);
+  g_queue_foreach (&priv->offer_pool, (GFunc) g_object_unref, NULL);
+  g_queue_clear (&priv->offer_pool);
 
   if (object_class->finalize != NULL)
     object_class->finalize (object);
 }
 
+/* Equal codec lists have equal fingerprints, so lists with different
+ * fingerprints can be told apart without comparing them field by field.
+ * Parameters are combined with a sum so their order doesn't matter, just like
+ * in tpy_base_media_call_codec_array_equal(). */
+static guint
+tpy_base_media_call_codec_array_fingerprint (const GPtrArray *codecs)
+{
+  guint h = 0;
+  guint i;
+
+  if (codecs == NULL)
+    return 0;
+
+  for (i = 0; i < codecs->len; i++)
+    {
+      GValueArray *codec = g_ptr_array_index (codecs, i);
+      const gchar *name;
+      GHashTable *params;
+      GHashTableIter iter;
+      gpointer key, value;
+      guint params_hash = 0;
+
+      name = g_value_get_string (codec->values + 1);
+
+      h = h * 31 + g_value_get_uint (codec->values + 0);
+      h = h * 31 + g_str_hash (name != NULL ? name : "");
+      h = h * 31 + g_value_get_uint (codec->values + 2);
+      h = h * 31 + g_value_get_uint (codec->values + 3);
+
+      params = g_value_get_boxed (codec->values + 4);
+      g_hash_table_iter_init (&iter, params);
+
+      while (g_hash_table_iter_next (&iter, &key, &value))
+        params_hash += g_str_hash (key) * 33 +
+            g_str_hash (value != NULL ? value : "");
+
+      h = h * 31 + params_hash;
+    }
+
+  return h;
+}
+
 static gboolean
 tpy_base_media_call_codec_array_equal (const GPtrArray *a, const GPtrArray *b)
 {
@@ -327,6 +592,347 @@ tpy_base_media_call_codec_array_equal (const GPtrArray *a, const GPtrArray *b)
   return TRUE;
 }
 
+/* Codec lists are interned process-wide: every codec list in a codec_map is
+ * shared with all the other contents holding an equal list, and must be
+ * treated as read-only. Like the rest of the library this is only used from
+ * the main thread. */
+typedef struct {
+    GPtrArray *codecs;
+    guint fingerprint;
+    guint refcount;
+    gsize size;
+} InternedCodecList;
+
+/* fingerprint => GSList of InternedCodecList */
+static GHashTable *interned_codec_lists = NULL;
+/* GPtrArray => InternedCodecList */
+static GHashTable *interned_codec_list_owners = NULL;
+static TpyCodecListStats interned_codec_list_stats = { 0, };
+
+/* Rough estimate of the memory used by a codec list */
+static gsize
+tpy_base_media_call_codec_list_size (const GPtrArray *codecs)
+{
+  gsize size = sizeof (GPtrArray) + codecs->len * sizeof (gpointer);
+  guint i;
+
+  for (i = 0; i < codecs->len; i++)
+    {
+      GValueArray *codec = g_ptr_array_index (codecs, i);
+      const gchar *name = g_value_get_string (codec->values + 1);
+      GHashTable *params = g_value_get_boxed (codec->values + 4);
+      GHashTableIter iter;
+      gpointer key, value;
+
+      size += sizeof (GValueArray) + codec->n_values * sizeof (GValue);
+
+      if (name != NULL)
+        size += strlen (name) + 1;
+
+      g_hash_table_iter_init (&iter, params);
+      while (g_hash_table_iter_next (&iter, &key, &value))
+        {
+          size += 3 * sizeof (gpointer) + strlen (key) + 1;
+
+          if (value != NULL)
+            size += strlen (value) + 1;
+        }
+    }
+
+  return size;
+}
+
+/* Returns a reference to the interned list equal to codecs, which must be
+ * released with tpy_base_media_call_codec_list_release(). If take is TRUE
+ * codecs is consumed, either by becoming the interned list or by being
+ * freed; otherwise it is copied if needed. */
+static GPtrArray *
+tpy_base_media_call_codec_list_intern (GPtrArray *codecs,
+    guint fingerprint,
+    gboolean take)
+{
+  InternedCodecList *entry = NULL;
+  GSList *chain, *l;
+
+  if (G_UNLIKELY (interned_codec_lists == NULL))
+    {
+      interned_codec_lists = g_hash_table_new_full (NULL, NULL, NULL,
+          (GDestroyNotify) g_slist_free);
+      interned_codec_list_owners = g_hash_table_new (NULL, NULL);
+    }
+
+  chain = g_hash_table_lookup (interned_codec_lists,
+      GUINT_TO_POINTER (fingerprint));
+
+  for (l = chain; l != NULL; l = l->next)
+    {
+      InternedCodecList *e = l->data;
+
+      if (tpy_base_media_call_codec_array_equal (e->codecs, codecs))
+        {
+          entry = e;
+          break;
+        }
+    }
+
+  if (entry != NULL)
+    {
+      if (take && entry->codecs != codecs)
+        _free_codec_array (codecs);
+
+      entry->refcount++;
+      interned_codec_list_stats.references++;
+      interned_codec_list_stats.bytes_saved += entry->size;
+
+      return entry->codecs;
+    }
+
+  entry = g_slice_new (InternedCodecList);
+  entry->codecs = take ? codecs
+      : g_boxed_copy (TPY_ARRAY_TYPE_CODEC_LIST, codecs);
+  entry->fingerprint = fingerprint;
+  entry->refcount = 1;
+  entry->size = tpy_base_media_call_codec_list_size (entry->codecs);
+
+  /* steal the chain so that replacing it doesn't free it */
+  g_hash_table_steal (interned_codec_lists, GUINT_TO_POINTER (fingerprint));
+  g_hash_table_insert (interned_codec_lists, GUINT_TO_POINTER (fingerprint),
+      g_slist_prepend (chain, entry));
+  g_hash_table_insert (interned_codec_list_owners, entry->codecs, entry);
+
+  interned_codec_list_stats.lists++;
+  interned_codec_list_stats.references++;
+  interned_codec_list_stats.bytes += entry->size;
+
+  return entry->codecs;
+}
+
+static void
+tpy_base_media_call_codec_list_release (gpointer codecs)
+{
+  InternedCodecList *entry;
+  GSList *chain;
+
+  entry = g_hash_table_lookup (interned_codec_list_owners, codecs);
+  g_return_if_fail (entry != NULL);
+
+  interned_codec_list_stats.references--;
+
+  if (--entry->refcount > 0)
+    {
+      interned_codec_list_stats.bytes_saved -= entry->size;
+      return;
+    }
+
+  chain = g_hash_table_lookup (interned_codec_lists,
+      GUINT_TO_POINTER (entry->fingerprint));
+  g_hash_table_steal (interned_codec_lists,
+      GUINT_TO_POINTER (entry->fingerprint));
+  chain = g_slist_remove (chain, entry);
+
+  if (chain != NULL)
+    g_hash_table_insert (interned_codec_lists,
+        GUINT_TO_POINTER (entry->fingerprint), chain);
+
+  g_hash_table_remove (interned_codec_list_owners, codecs);
+
+  interned_codec_list_stats.lists--;
+  interned_codec_list_stats.bytes -= entry->size;
+
+  _free_codec_array (entry->codecs);
+  g_slice_free (InternedCodecList, entry);
+}
+
+/**
+ * tpy_base_media_call_content_get_codec_list_stats:
+ *
+ * Fills in @stats with the codec lists shared by all the contents of the
+ * process, and roughly how much memory sharing them saves.
+ */
+void
+tpy_base_media_call_content_get_codec_list_stats (TpyCodecListStats *stats)
+{
+  g_return_if_fail (stats != NULL);
+
+  *stats = interned_codec_list_stats;
+}
+
+/* Results of finished offers on a content with negotiation-cache set. An
+ * entry is found from the codecs offered by the remote contact, the media
+ * type and the local codecs known when the offer was made.
+ *
+ * This is deliberately not shared between contents: answering a content's
+ * first offer from the cache would mean never sending NewCodecOffer, and
+ * the streaming implementation only configures its decoders from that. */
+typedef struct {
+    guint hash;
+    TpMediaStreamType media_type;
+    /* interned; capabilities may be NULL */
+    GPtrArray *remote;
+    GPtrArray *capabilities;
+    GPtrArray *accepted;
+    /* the content's negotiations_order, and our link in it */
+    GQueue *order;
+    GList *link;
+} NegotiationCacheEntry;
+
+static guint negotiation_cache_size = DEFAULT_NEGOTIATION_CACHE_SIZE;
+static TpyNegotiationCacheEviction negotiation_cache_eviction =
+    TPY_NEGOTIATION_CACHE_EVICT_LEAST_RECENTLY_USED;
+
+static guint
+negotiation_cache_entry_hash (gconstpointer key)
+{
+  const NegotiationCacheEntry *entry = key;
+
+  return entry->hash;
+}
+
+static gboolean
+negotiation_cache_entry_equal (gconstpointer a,
+    gconstpointer b)
+{
+  const NegotiationCacheEntry *ea = a;
+  const NegotiationCacheEntry *eb = b;
+
+  return ea->hash == eb->hash &&
+      ea->media_type == eb->media_type &&
+      tpy_base_media_call_codec_array_equal (ea->remote, eb->remote) &&
+      tpy_base_media_call_codec_array_equal (ea->capabilities,
+          eb->capabilities);
+}
+
+static void
+negotiation_cache_entry_free (gpointer data)
+{
+  NegotiationCacheEntry *entry = data;
+
+  g_queue_delete_link (entry->order, entry->link);
+  tpy_base_media_call_codec_list_release (entry->remote);
+  tpy_base_media_call_codec_list_release (entry->accepted);
+
+  if (entry->capabilities != NULL)
+    tpy_base_media_call_codec_list_release (entry->capabilities);
+
+  g_slice_free (NegotiationCacheEntry, entry);
+}
+
+static void
+negotiation_cache_entry_init_key (NegotiationCacheEntry *entry,
+    TpMediaStreamType media_type,
+    GPtrArray *remote,
+    guint remote_fingerprint,
+    GPtrArray *capabilities)
+{
+  entry->media_type = media_type;
+  entry->remote = remote;
+  entry->capabilities = capabilities;
+  entry->hash = (remote_fingerprint * 31 +
+      tpy_base_media_call_codec_array_fingerprint (capabilities)) * 31 +
+      media_type;
+}
+
+static void
+negotiation_cache_trim (TpyBaseMediaCallContent *self,
+    guint size)
+{
+  TpyBaseMediaCallContentPrivate *priv = self->priv;
+
+  while (g_queue_get_length (&priv->negotiations_order) > size)
+    g_hash_table_remove (priv->negotiations,
+        g_queue_peek_tail (&priv->negotiations_order));
+}
+
+static NegotiationCacheEntry *
+negotiation_cache_lookup (TpyBaseMediaCallContent *self,
+    GPtrArray *remote,
+    guint remote_fingerprint,
+    GPtrArray *capabilities)
+{
+  TpyBaseMediaCallContentPrivate *priv = self->priv;
+  NegotiationCacheEntry key;
+  NegotiationCacheEntry *entry;
+
+  if (priv->negotiations == NULL)
+    return NULL;
+
+  /* the size may have been lowered since the last store */
+  negotiation_cache_trim (self, negotiation_cache_size);
+
+  negotiation_cache_entry_init_key (&key,
+      tpy_base_call_content_get_media_type (TPY_BASE_CALL_CONTENT (self)),
+      remote, remote_fingerprint, capabilities);
+  entry = g_hash_table_lookup (priv->negotiations, &key);
+
+  if (entry != NULL && negotiation_cache_eviction ==
+      TPY_NEGOTIATION_CACHE_EVICT_LEAST_RECENTLY_USED)
+    {
+      g_queue_unlink (&priv->negotiations_order, entry->link);
+      g_queue_push_head_link (&priv->negotiations_order, entry->link);
+    }
+
+  return entry;
+}
+
+/* All the lists are interned ones, which the cache takes new references to */
+static void
+negotiation_cache_store (TpyBaseMediaCallContent *self,
+    GPtrArray *remote,
+    guint remote_fingerprint,
+    GPtrArray *capabilities,
+    GPtrArray *accepted)
+{
+  TpyBaseMediaCallContentPrivate *priv = self->priv;
+  NegotiationCacheEntry *entry;
+
+  if (negotiation_cache_size == 0)
+    {
+      tp_clear_pointer (&priv->negotiations, g_hash_table_unref);
+      return;
+    }
+
+  if (priv->negotiations == NULL)
+    priv->negotiations = g_hash_table_new_full (negotiation_cache_entry_hash,
+        negotiation_cache_entry_equal, negotiation_cache_entry_free, NULL);
+
+  entry = g_slice_new0 (NegotiationCacheEntry);
+  negotiation_cache_entry_init_key (entry,
+      tpy_base_call_content_get_media_type (TPY_BASE_CALL_CONTENT (self)),
+      tpy_base_media_call_codec_list_intern (remote, remote_fingerprint,
+          FALSE),
+      remote_fingerprint,
+      capabilities == NULL ? NULL : tpy_base_media_call_codec_list_intern (
+          capabilities, tpy_base_media_call_codec_array_fingerprint (
+              capabilities), FALSE));
+  entry->accepted = tpy_base_media_call_codec_list_intern (accepted,
+      tpy_base_media_call_codec_array_fingerprint (accepted), FALSE);
+
+  /* replaces (and frees) any equal entry, unlinking it */
+  g_hash_table_remove (priv->negotiations, entry);
+  entry->order = &priv->negotiations_order;
+  g_queue_push_head (entry->order, entry);
+  entry->link = entry->order->head;
+  g_hash_table_insert (priv->negotiations, entry, entry);
+
+  negotiation_cache_trim (self, negotiation_cache_size);
+}
+
+/**
+ * tpy_base_media_call_content_configure_negotiation_cache:
+ *
+ * Sets how many negotiation results each content with
+ * #TpyBaseMediaCallContent:negotiation-cache set keeps, and which are
+ * dropped first once there are too many. A @size of 0 disables the cache.
+ * Existing caches are trimmed the next time they are used.
+ */
+void
+tpy_base_media_call_content_configure_negotiation_cache (guint size,
+    TpyNegotiationCacheEviction eviction)
+{
+  negotiation_cache_size = size;
+  negotiation_cache_eviction = eviction;
+}
+
 static void
 tpy_base_media_call_content_set_local_codecs (TpyBaseMediaCallContent *self,
   const GPtrArray *codecs)
@@ -335,14 +941,25 @@ tpy_base_media_call_content_set_local_codecs (TpyBaseMediaCallContent *self,
   TpBaseConnection *conn = tpy_base_call_content_get_connection (
       TPY_BASE_CALL_CONTENT (self));
   GPtrArray *c;
+  guint fingerprint;
+
+  fingerprint = tpy_base_media_call_codec_array_fingerprint (codecs);
 
-  if (tpy_base_media_call_codec_array_equal (priv->local_codecs, codecs))
+  /* Only compare the lists in full if they could be the same */
+  if (priv->local_codecs != NULL &&
+      priv->local_codecs_fingerprint == fingerprint &&
+      tpy_base_media_call_codec_array_equal (priv->local_codecs, codecs))
     return;
 
-  c = g_boxed_copy (TPY_ARRAY_TYPE_CODEC_LIST, codecs);
+  c = tpy_base_media_call_codec_list_intern ((GPtrArray *) codecs,
+      fingerprint, FALSE);
   priv->local_codecs = c;
+  priv->local_codecs_fingerprint = fingerprint;
   g_hash_table_replace (priv->codec_map, GUINT_TO_POINTER (conn->self_handle),
        c);
+  g_hash_table_insert (priv->changed_codecs,
+      GUINT_TO_POINTER (conn->self_handle),
+      GUINT_TO_POINTER (conn->self_handle));
 
   g_signal_emit (self, signals[LOCAL_CODECS_UPDATED], 0, priv->local_codecs);
 }
@@ -407,6 +1024,9 @@ call_content_deinit (TpyBaseCallContent *base)
 {
   TpyBaseMediaCallContent *self = TPY_BASE_MEDIA_CALL_CONTENT (base);
   TpyBaseMediaCallContentPrivate *priv = self->priv;
+  GHashTableIter iter;
+  gpointer value;
+  gboolean cancelled = FALSE;
 
   if (priv->deinit_has_run)
     return;
@@ -419,18 +1039,178 @@ call_content_deinit (TpyBaseCallContent *base)
    */
   g_object_ref (base);
 
-  g_queue_foreach (priv->outstanding_offers, (GFunc) g_object_unref, NULL);
-  g_queue_clear (priv->outstanding_offers);
+  g_queue_foreach (&priv->offer_pool, (GFunc) g_object_unref, NULL);
+  g_queue_clear (&priv->offer_pool);
 
-  if (priv->offer_cancellable != NULL)
-    g_cancellable_cancel (priv->offer_cancellable);
-  else
+  /* Drop queued offers; the running ones finish (and drop their part of
+   * offer_count) once cancelled */
+  g_hash_table_iter_init (&iter, priv->offer_lanes);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      OfferLane *lane = value;
+
+      priv->offer_count -= g_queue_get_length (&lane->pending);
+      g_queue_foreach (&lane->pending, (GFunc) g_object_unref, NULL);
+      g_queue_clear (&lane->pending);
+
+      if (lane->timeout_id != 0)
+        {
+          g_source_remove (lane->timeout_id);
+          lane->timeout_id = 0;
+        }
+
+      if (lane->cancellable != NULL)
+        {
+          g_cancellable_cancel (lane->cancellable);
+          cancelled = TRUE;
+        }
+    }
+
+  if (!cancelled)
     maybe_finish_deinit (self);
 
   TPY_BASE_CALL_CONTENT_CLASS (
     tpy_base_media_call_content_parent_class)->deinit (base);
 }
 
+static guint
+offer_lane_key (TpyBaseMediaCallContent *self,
+    TpyCallContentCodecOffer *offer)
+{
+  TpHandle contact;
+
+  if (!self->priv->parallel_offers)
+    return 0;
+
+  g_object_get (offer, "remote-contact", &contact, NULL);
+  return contact;
+}
+
+static TpyCallContentCodecOffer *
+find_running_offer (TpyBaseMediaCallContent *self)
+{
+  GHashTableIter iter;
+  gpointer value;
+
+  g_hash_table_iter_init (&iter, self->priv->offer_lanes);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      OfferLane *lane = value;
+
+      if (lane->current != NULL)
+        return lane->current;
+    }
+
+  return NULL;
+}
+
+static GQuark
+pooled_offer_quark (void)
+{
+  static GQuark quark = 0;
+
+  if (G_UNLIKELY (quark == 0))
+    quark = g_quark_from_static_string ("tpy-base-media-call-content-pool");
+
+  return quark;
+}
+
+/* Takes the reference to a finished offer */
+static void
+release_offer (TpyBaseMediaCallContent *self,
+    TpyCallContentCodecOffer *offer)
+{
+  TpyBaseMediaCallContentPrivate *priv = self->priv;
+
+  if (!priv->deinit_has_run &&
+      g_object_get_qdata (G_OBJECT (offer), pooled_offer_quark ()) != NULL &&
+      g_queue_get_length (&priv->offer_pool) < MAX_POOLED_OFFERS)
+    {
+      g_queue_push_tail (&priv->offer_pool, offer);
+      return;
+    }
+
+  g_object_unref (offer);
+}
+
+static void
+queue_codec_changes (TpyBaseMediaCallContent *self)
+{
+  TpyBaseMediaCallContentPrivate *priv = self->priv;
+
+  if (!priv->coalesce_codec_changes)
+    base_media_call_content_flush_codec_changes (self);
+  else if (priv->codecs_changed_idle_id == 0)
+    priv->codecs_changed_idle_id = g_idle_add (
+        base_media_call_content_flush_codec_changes_idle, self);
+}
+
+/* Completes the offer straight away if it only repeats the codecs the
+ * streaming implementation already has for this contact on this content,
+ * and an identical offer was answered here before; returns FALSE if it has
+ * to go to the streaming implementation */
+static gboolean
+answer_offer_from_cache (TpyBaseMediaCallContent *self,
+    TpyCallContentCodecOffer *offer)
+{
+  TpyBaseMediaCallContentPrivate *priv = self->priv;
+  NegotiationCacheEntry *entry = NULL;
+  GPtrArray *codecs;
+  GPtrArray *known;
+  TpHandle contact;
+  guint fingerprint = 0;
+
+  if (!priv->negotiation_cache || priv->negotiations == NULL)
+    return FALSE;
+
+  g_object_get (offer,
+    "remote-contact-codecs", &codecs,
+    "remote-contact", &contact,
+    NULL);
+
+  /* The streaming implementation only knows the remote codecs it was last
+   * offered for the contact; anything else has to be offered to it */
+  known = g_hash_table_lookup (priv->codec_map, GUINT_TO_POINTER (contact));
+
+  if (known != NULL && tpy_base_media_call_codec_array_equal (known, codecs))
+    {
+      fingerprint = tpy_base_media_call_codec_array_fingerprint (codecs);
+      entry = negotiation_cache_lookup (self, codecs, fingerprint,
+          priv->local_codecs);
+    }
+
+  _free_codec_array (codecs);
+
+  if (entry == NULL)
+    return FALSE;
+
+  DEBUG ("Answering the offer for %u from the negotiation cache", contact);
+
+  /* Lists are interned, so the same pointer means nothing changed */
+  if (entry->remote != known)
+    {
+      g_hash_table_replace (priv->codec_map, GUINT_TO_POINTER (contact),
+          tpy_base_media_call_codec_list_intern (entry->remote, fingerprint,
+              FALSE));
+      g_hash_table_insert (priv->changed_codecs, GUINT_TO_POINTER (contact),
+          GUINT_TO_POINTER (contact));
+    }
+
+  /* entry may be evicted by anything run from here on */
+  tpy_base_media_call_content_set_local_codecs (self, entry->accepted);
+  queue_codec_changes (self);
+
+  --priv->offer_count;
+  release_offer (self, offer);
+
+  /* deinit may have been started by a local-codecs-updated handler, and
+   * have been waiting for this offer */
+  if (priv->deinit_has_run)
+    maybe_finish_deinit (self);
+
+  return TRUE;
+}
+
 static void
 codec_offer_finished_cb (GObject *source,
     GAsyncResult *result,
@@ -443,13 +1223,17 @@ codec_offer_finished_cb (GObject *source,
   GPtrArray *local_codecs;
   TpHandle contact;
   GPtrArray *codecs;
-  GArray *empty;
+  guint lane_key;
+  OfferLane *lane;
+
+  lane_key = offer_lane_key (self, offer);
+  lane = g_hash_table_lookup (priv->offer_lanes, GUINT_TO_POINTER (lane_key));
 
   local_codecs = tpy_call_content_codec_offer_offer_finish (
     offer, result, &error);
 
   if (error != NULL || priv->deinit_has_run ||
-      priv->current_offer != TPY_CALL_CONTENT_CODEC_OFFER (source))
+      lane == NULL || lane->current != offer)
     goto out;
 
   g_object_get (offer,
@@ -458,66 +1242,192 @@ codec_offer_finished_cb (GObject *source,
     NULL);
 
   if (codecs->len > 0)
-    g_hash_table_replace (priv->codec_map, GUINT_TO_POINTER (contact), codecs);
+    {
+      guint fingerprint = tpy_base_media_call_codec_array_fingerprint (codecs);
+
+      codecs = tpy_base_media_call_codec_list_intern (codecs, fingerprint,
+          TRUE);
+
+      if (priv->negotiation_cache && local_codecs != NULL)
+        negotiation_cache_store (self, codecs, fingerprint,
+            lane->capabilities, local_codecs);
+
+      /* Lists are interned, so the same pointer means nothing changed */
+      if (g_hash_table_lookup (priv->codec_map, GUINT_TO_POINTER (contact))
+          != codecs)
+        g_hash_table_insert (priv->changed_codecs,
+            GUINT_TO_POINTER (contact), GUINT_TO_POINTER (contact));
+
+      g_hash_table_replace (priv->codec_map, GUINT_TO_POINTER (contact),
+          codecs);
+    }
   else
-    _free_codec_array (codecs);
+    {
+      _free_codec_array (codecs);
+    }
 
   tpy_base_media_call_content_set_local_codecs (self, local_codecs);
-
-  empty = g_array_new (FALSE, FALSE, sizeof (TpHandle));
-  tpy_svc_call_content_interface_media_emit_codecs_changed (self,
-      priv->codec_map, empty);
-   g_array_free (empty, TRUE);
+  queue_codec_changes (self);
 
 out:
-  if (priv->current_offer == TPY_CALL_CONTENT_CODEC_OFFER (source))
+  g_clear_error (&error);
+
+  if (lane != NULL && lane->current == offer)
     {
-      priv->current_offer = NULL;
-      priv->offer_cancellable = NULL;
+      lane->current = NULL;
+      lane->cancellable = NULL;
+
+      if (lane->timeout_id != 0)
+        {
+          g_source_remove (lane->timeout_id);
+          lane->timeout_id = 0;
+        }
+
+      if (lane->capabilities != NULL)
+        {
+          tpy_base_media_call_codec_list_release (lane->capabilities);
+          lane->capabilities = NULL;
+        }
     }
 
+  if (priv->current_offer == offer)
+    priv->current_offer = find_running_offer (self);
+
   --priv->offer_count;
-  g_object_unref (source);
+  release_offer (self, offer);
 
   if (priv->deinit_has_run)
     maybe_finish_deinit (self);
   else
-    tpy_base_media_call_content_next_offer (self);
+    tpy_base_media_call_content_next_offer (self, lane_key);
+}
+
+typedef struct {
+    TpyBaseMediaCallContent *self;
+    guint lane_key;
+} OfferTimeoutData;
+
+static void
+offer_timeout_data_free (gpointer data)
+{
+  g_slice_free (OfferTimeoutData, data);
+}
+
+static gboolean
+offer_timeout_cb (gpointer user_data)
+{
+  OfferTimeoutData *data = user_data;
+  TpyBaseMediaCallContent *self = data->self;
+  TpyBaseMediaCallContentPrivate *priv = self->priv;
+  OfferLane *lane;
+  TpyCallContentCodecOffer *offer;
+
+  lane = g_hash_table_lookup (priv->offer_lanes,
+      GUINT_TO_POINTER (data->lane_key));
+  g_return_val_if_fail (lane != NULL && lane->current != NULL, FALSE);
+
+  offer = lane->current;
+  lane->timeout_id = 0;
+  priv->offer_timeouts++;
+
+  DEBUG ("Codec offer for lane %u timed out, cancelling it", data->lane_key);
+
+  /* The cancelled offer completes (and drops its part of offer_count) from
+   * an idle; the lane doesn't wait for that before going on */
+  lane->current = NULL;
+  g_cancellable_cancel (lane->cancellable);
+  lane->cancellable = NULL;
+
+  if (lane->capabilities != NULL)
+    {
+      tpy_base_media_call_codec_list_release (lane->capabilities);
+      lane->capabilities = NULL;
+    }
+
+  if (priv->current_offer == offer)
+    priv->current_offer = find_running_offer (self);
+
+  g_object_notify (G_OBJECT (self), "offer-timeouts");
+  tpy_base_media_call_content_next_offer (self, data->lane_key);
+
+  return FALSE;
 }
 
 static void
-tpy_base_media_call_content_next_offer (TpyBaseMediaCallContent *self)
+tpy_base_media_call_content_next_offer (TpyBaseMediaCallContent *self,
+    guint lane_key)
 {
   TpyBaseMediaCallContentPrivate *priv = self->priv;
   TpyCallContentCodecOffer *offer;
+  OfferLane *lane;
   gchar *path;
   GPtrArray *codecs;
   TpHandle handle;
 
-  if (priv->current_offer != NULL)
+  lane = g_hash_table_lookup (priv->offer_lanes, GUINT_TO_POINTER (lane_key));
+
+  if (lane == NULL)
+    return;
+
+  if (lane->current != NULL)
     {
       DEBUG ("Waiting for the current offer to finish"
         " before starting the next one");
       return;
     }
 
-  offer = g_queue_pop_head (priv->outstanding_offers);
+  /* local-codecs-updated handlers run while answering from the cache may
+   * deinit us, which can drop the last reference to us */
+  g_object_ref (self);
+
+  while ((offer = g_queue_pop_head (&lane->pending)) != NULL &&
+      answer_offer_from_cache (self, offer))
+    {
+      /* ... or start another offer */
+      lane = g_hash_table_lookup (priv->offer_lanes,
+          GUINT_TO_POINTER (lane_key));
+
+      if (priv->deinit_has_run || lane == NULL || lane->current != NULL)
+        {
+          g_object_unref (self);
+          return;
+        }
+    }
+
+  g_object_unref (self);
 
   if (offer == NULL)
     {
       DEBUG ("No more offers outstanding");
+      g_hash_table_remove (priv->offer_lanes, GUINT_TO_POINTER (lane_key));
       return;
     }
 
+  lane->current = offer;
   priv->current_offer = offer;
 
-  g_assert (priv->offer_cancellable == NULL);
-  priv->offer_cancellable = g_cancellable_new ();
+  g_assert (lane->cancellable == NULL);
+  lane->cancellable = g_cancellable_new ();
+
+  g_assert (lane->capabilities == NULL);
+  if (priv->local_codecs != NULL)
+    lane->capabilities = tpy_base_media_call_codec_list_intern (
+        priv->local_codecs, priv->local_codecs_fingerprint, FALSE);
 
-  tpy_call_content_codec_offer_offer (priv->current_offer,
-    priv->offer_cancellable,
+  tpy_call_content_codec_offer_offer (offer, lane->cancellable,
     codec_offer_finished_cb, self);
 
+  if (priv->offer_timeout > 0)
+    {
+      OfferTimeoutData *data = g_slice_new (OfferTimeoutData);
+
+      data->self = self;
+      data->lane_key = lane_key;
+      lane->timeout_id = g_timeout_add_full (G_PRIORITY_DEFAULT,
+          priv->offer_timeout, offer_timeout_cb, data,
+          offer_timeout_data_free);
+    }
+
   g_object_get (offer,
       "object-path", &path,
       "remote-contact", &handle,
@@ -537,16 +1447,75 @@ tpy_base_media_call_content_add_offer (TpyBaseMediaCallContent *self,
   TpyCallContentCodecOffer *offer)
 {
   TpyBaseMediaCallContentPrivate *priv = self->priv;
+  guint lane_key = offer_lane_key (self, offer);
+  OfferLane *lane;
 
   ++priv->offer_count;
   /* set this to TRUE so that after the initial offer disappears,
    * UpdateCodecs is allowed to be called. */
   priv->initial_offer_appeared = TRUE;
 
-  g_queue_push_tail (priv->outstanding_offers, offer);
-  tpy_base_media_call_content_next_offer (self);
+  lane = g_hash_table_lookup (priv->offer_lanes, GUINT_TO_POINTER (lane_key));
+
+  if (lane == NULL)
+    {
+      lane = g_slice_new0 (OfferLane);
+      g_queue_init (&lane->pending);
+      g_hash_table_insert (priv->offer_lanes, GUINT_TO_POINTER (lane_key),
+          lane);
+    }
+
+  g_queue_push_tail (&lane->pending, offer);
+  tpy_base_media_call_content_next_offer (self, lane_key);
 }
 
+/**
+ * tpy_base_media_call_content_offer_codecs:
+ *
+ * Like tpy_base_media_call_content_add_offer(), but the offer object is
+ * recycled from an earlier offer on this content if possible. Each offer
+ * still gets its own object path.
+ */
+void
+tpy_base_media_call_content_offer_codecs (TpyBaseMediaCallContent *self,
+  TpHandle remote_contact,
+  GPtrArray *codecs)
+{
+  TpyBaseMediaCallContentPrivate *priv = self->priv;
+  TpyCallContentCodecOffer *offer;
+  gchar *path;
+
+  g_return_if_fail (!priv->deinit_has_run);
+
+  path = g_strdup_printf ("%s/CodecOffer%u",
+      tpy_base_call_content_get_object_path (TPY_BASE_CALL_CONTENT (self)),
+      priv->pooled_offer_serial++);
+
+  offer = g_queue_pop_head (&priv->offer_pool);
+
+  if (offer != NULL)
+    {
+      tpy_call_content_codec_offer_reset (offer, path, remote_contact, codecs);
+    }
+  else
+    {
+      offer = tpy_call_content_codec_offer_new (path, remote_contact, codecs);
+      g_object_set_qdata (G_OBJECT (offer), pooled_offer_quark (), self);
+    }
+
+  g_free (path);
+
+  tpy_base_media_call_content_add_offer (self, offer);
+}
+
+/**
+ * tpy_base_media_call_content_get_local_codecs:
+ *
+ * Returns: (transfer none): the local codecs, as a TPY_ARRAY_TYPE_CODEC_LIST
+ *  owned by @self, or %NULL. It stays valid until the local codecs change
+ *  (see #TpyBaseMediaCallContent::local-codecs-updated) or @self is
+ *  disposed. It is immutable: copy it to make changes.
+ */
 GPtrArray *
 tpy_base_media_call_content_get_local_codecs (TpyBaseMediaCallContent *self)
 {
@@ -33,6 +33,24 @@ typedef struct _TpyBaseMediaCallContent TpyBaseMediaCallContent;
 typedef struct _TpyBaseMediaCallContentPrivate TpyBaseMediaCallContentPrivate;
 typedef struct _TpyBaseMediaCallContentClass TpyBaseMediaCallContentClass;
 
+typedef struct {
+    /* distinct codec lists */
+    guint lists;
+    /* codec map and negotiation cache entries using them */
+    guint references;
+    /* approximate bytes used by the lists */
+    gsize bytes;
+    /* approximate bytes that separate copies would have used on top */
+    gsize bytes_saved;
+} TpyCodecListStats;
+
+typedef enum {
+    /* drop the entry that was used or added least recently */
+    TPY_NEGOTIATION_CACHE_EVICT_LEAST_RECENTLY_USED,
+    /* drop the entry that was added first */
+    TPY_NEGOTIATION_CACHE_EVICT_OLDEST
+} TpyNegotiationCacheEviction;
+
 struct _TpyBaseMediaCallContentClass {
     TpyBaseCallContentClass parent_class;
 };
@@ -67,6 +85,14 @@ GPtrArray *tpy_base_media_call_content_get_local_codecs (
 
 void tpy_base_media_call_content_add_offer (TpyBaseMediaCallContent *self,
     TpyCallContentCodecOffer *offer);
+void tpy_base_media_call_content_offer_codecs (TpyBaseMediaCallContent *self,
+    TpHandle remote_contact,
+    GPtrArray *codecs);
+
+void tpy_base_media_call_content_get_codec_list_stats (
+    TpyCodecListStats *stats);
+void tpy_base_media_call_content_configure_negotiation_cache (guint size,
+    TpyNegotiationCacheEviction eviction);
 
 G_END_DECLS
 
@@ -36,6 +36,7 @@
 #include <telepathy-yell/interfaces.h>
 #include <telepathy-yell/svc-call.h>
 #include <telepathy-yell/call-stream-endpoint.h>
+#include <telepathy-yell/extensions.h>
 
 #define DEBUG_FLAG TPY_DEBUG_CALL
 #include "debug.h"
@@ -58,6 +59,8 @@ enum
   PROP_STUN_SERVERS,
   PROP_RELAY_INFO,
   PROP_HAS_SERVER_INFO,
+  PROP_CANDIDATE_BATCH_SIZE,
+  PROP_CANDIDATE_BATCH_LATENCY,
 };
 
 /* private structure */
@@ -66,7 +69,15 @@ struct _TpyBaseMediaCallStreamPrivate
   gboolean dispose_has_run;
 
   GList *endpoints;
+  /* Endpoints property; borrowed paths, built when first read */
+  GPtrArray *endpoint_paths;
   GPtrArray *local_candidates;
+  /* candidates accepted but not yet signalled, see
+   * base_media_call_stream_queue_local_candidates */
+  GPtrArray *pending_candidates;
+  guint candidate_batch_size;
+  guint candidate_batch_latency;
+  guint candidates_flush_id;
   GPtrArray *relay_info;
   GPtrArray *stun_servers;
   TpyStreamTransportType transport;
@@ -84,7 +95,10 @@ tpy_base_media_call_stream_init (TpyBaseMediaCallStream *self)
 
   self->priv = priv;
 
-  priv->local_candidates = g_ptr_array_new ();
+  priv->local_candidates = g_ptr_array_new_with_free_func (
+      (GDestroyNotify) tpy_call_stream_candidate_free);
+  priv->pending_candidates = g_ptr_array_new ();
+  priv->candidate_batch_size = 1;
   priv->relay_info = g_ptr_array_new ();
   priv->stun_servers = g_ptr_array_new ();
 
@@ -117,7 +131,9 @@ tpy_base_media_call_stream_get_property (GObject    *object,
     {
       case PROP_LOCAL_CANDIDATES:
         {
-          g_value_set_boxed (value, stream->priv->local_candidates);
+          g_value_take_boxed (value,
+              tpy_call_stream_candidate_list_to_value_arrays (
+                  stream->priv->local_candidates));
           break;
         }
       case PROP_LOCAL_CREDENTIALS:
@@ -130,18 +146,22 @@ tpy_base_media_call_stream_get_property (GObject    *object,
         }
       case PROP_ENDPOINTS:
         {
-          GPtrArray *arr = g_ptr_array_sized_new (1);
-          GList *l;
-
-          for (l = priv->endpoints; l != NULL; l = g_list_next (l))
+          if (priv->endpoint_paths == NULL)
             {
-              TpyCallStreamEndpoint *e =
-                TPY_CALL_STREAM_ENDPOINT (l->data);
-              g_ptr_array_add (arr,
-                g_strdup (tpy_call_stream_endpoint_get_object_path (e)));
+              GList *l;
+
+              priv->endpoint_paths = g_ptr_array_sized_new (
+                  g_list_length (priv->endpoints));
+
+              for (l = priv->endpoints; l != NULL; l = g_list_next (l))
+                g_ptr_array_add (priv->endpoint_paths, (gpointer)
+                    tpy_call_stream_endpoint_get_object_path (
+                        TPY_CALL_STREAM_ENDPOINT (l->data)));
             }
 
-          g_value_take_boxed (value, arr);
+          /* endpoints are only ever added, and the array is kept up to
+           * date when they are */
+          g_value_set_static_boxed (value, priv->endpoint_paths);
           break;
         }
       case PROP_TRANSPORT:
@@ -165,12 +185,131 @@ tpy_base_media_call_stream_get_property (GObject    *object,
           g_value_set_boolean (value, has_server_info (stream));
           break;
         }
+      case PROP_CANDIDATE_BATCH_SIZE:
+        g_value_set_uint (value, priv->candidate_batch_size);
+        break;
+      case PROP_CANDIDATE_BATCH_LATENCY:
+        g_value_set_uint (value, priv->candidate_batch_latency);
+        break;
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
         break;
     }
 }
 
+/* Called with the property IDs from stream_media_props */
+static void
+tpy_base_media_call_stream_get_dbus_property (GObject *object,
+    GQuark iface,
+    GQuark name,
+    GValue *value,
+    gpointer getter_data)
+{
+  tpy_base_media_call_stream_get_property (object,
+      GPOINTER_TO_UINT (getter_data), value, NULL);
+}
+
+static gboolean
+candidates_batched (TpyBaseMediaCallStream *self)
+{
+  return self->priv->candidate_batch_size != 1 ||
+      self->priv->candidate_batch_latency > 0;
+}
+
+static void
+clear_pending_candidates (TpyBaseMediaCallStream *self)
+{
+  TpyBaseMediaCallStreamPrivate *priv = self->priv;
+
+  if (priv->candidates_flush_id != 0)
+    {
+      g_source_remove (priv->candidates_flush_id);
+      priv->candidates_flush_id = 0;
+    }
+
+  g_ptr_array_foreach (priv->pending_candidates,
+      (GFunc) tpy_call_stream_candidate_free, NULL);
+  g_ptr_array_set_size (priv->pending_candidates, 0);
+}
+
+static void
+base_media_call_stream_flush_local_candidates (TpyBaseMediaCallStream *self)
+{
+  TpyBaseMediaCallStreamPrivate *priv = self->priv;
+  GPtrArray *candidates;
+  guint i;
+
+  if (priv->candidates_flush_id != 0)
+    {
+      g_source_remove (priv->candidates_flush_id);
+      priv->candidates_flush_id = 0;
+    }
+
+  if (priv->pending_candidates->len == 0)
+    return;
+
+  candidates = tpy_call_stream_candidate_list_to_value_arrays (
+      priv->pending_candidates);
+
+  for (i = 0; i < priv->pending_candidates->len; i++)
+    g_ptr_array_add (priv->local_candidates,
+        g_ptr_array_index (priv->pending_candidates, i));
+  g_ptr_array_set_size (priv->pending_candidates, 0);
+
+  DEBUG ("Signalling %u batched local candidates", candidates->len);
+
+  tpy_svc_call_stream_interface_media_emit_local_candidates_added (self,
+      candidates);
+  tpy_dbus_properties_queue_changed (G_OBJECT (self),
+      TPY_IFACE_CALL_STREAM_INTERFACE_MEDIA, "LocalCandidates");
+
+  g_boxed_free (TPY_ARRAY_TYPE_CANDIDATE_LIST, candidates);
+}
+
+static gboolean
+flush_local_candidates_timeout_cb (gpointer user_data)
+{
+  TpyBaseMediaCallStream *self = user_data;
+
+  self->priv->candidates_flush_id = 0;
+  base_media_call_stream_flush_local_candidates (self);
+
+  return FALSE;
+}
+
+/* Queues @candidates (a TPY_ARRAY_TYPE_CANDIDATE_LIST) to be signalled with
+ * the next batch, which goes out once candidate-batch-size candidates are
+ * pending, candidate-batch-latency ms after the first of them was queued or
+ * when the streaming implementation calls CandidatesPrepared, whichever
+ * comes first. */
+static void
+base_media_call_stream_queue_local_candidates (TpyBaseMediaCallStream *self,
+    const GPtrArray *candidates)
+{
+  TpyBaseMediaCallStreamPrivate *priv = self->priv;
+  guint i;
+
+  for (i = 0; i < candidates->len; i++)
+    {
+      TpyCallStreamCandidate *c =
+          tpy_call_stream_candidate_new_from_value_array (
+              g_ptr_array_index (candidates, i));
+
+      if (c != NULL)
+        g_ptr_array_add (priv->pending_candidates, c);
+    }
+
+  if (priv->candidate_batch_size > 0 &&
+      priv->pending_candidates->len >= priv->candidate_batch_size)
+    base_media_call_stream_flush_local_candidates (self);
+  else if (priv->candidate_batch_latency > 0 &&
+      priv->candidates_flush_id == 0 &&
+      priv->pending_candidates->len > 0)
+    priv->candidates_flush_id = g_timeout_add (
+        priv->candidate_batch_latency, flush_local_candidates_timeout_cb,
+        self);
+}
+
 static void
 tpy_base_media_call_stream_set_property (GObject *object,
     guint property_id,
@@ -185,6 +324,16 @@ tpy_base_media_call_stream_set_property (GObject *object,
       case PROP_TRANSPORT:
         priv->transport = g_value_get_uint (value);
         break;
+      case PROP_CANDIDATE_BATCH_SIZE:
+        priv->candidate_batch_size = g_value_get_uint (value);
+        if (!candidates_batched (stream))
+          base_media_call_stream_flush_local_candidates (stream);
+        break;
+      case PROP_CANDIDATE_BATCH_LATENCY:
+        priv->candidate_batch_latency = g_value_get_uint (value);
+        if (!candidates_batched (stream))
+          base_media_call_stream_flush_local_candidates (stream);
+        break;
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
         break;
@@ -195,7 +344,11 @@ static void
 maybe_emit_server_info_retrieved (TpyBaseMediaCallStream *self)
 {
   if (has_server_info (self))
-    tpy_svc_call_stream_interface_media_emit_server_info_retrieved (self);
+    {
+      tpy_svc_call_stream_interface_media_emit_server_info_retrieved (self);
+      tpy_dbus_properties_queue_changed (G_OBJECT (self),
+          TPY_IFACE_CALL_STREAM_INTERFACE_MEDIA, "HasServerInfo");
+    }
 }
 
 void
@@ -214,6 +367,8 @@ tpy_base_media_call_stream_set_relay_info (
 
   tpy_svc_call_stream_interface_media_emit_relay_info_changed (
       self, priv->relay_info);
+  tpy_dbus_properties_queue_changed (G_OBJECT (self),
+      TPY_IFACE_CALL_STREAM_INTERFACE_MEDIA, "RelayInfo");
 
   if (!priv->got_relay_info)
     {
@@ -235,6 +390,13 @@ tpy_base_media_call_stream_take_endpoint (
     TpyCallStreamEndpoint *endpoint)
 {
   self->priv->endpoints = g_list_append (self->priv->endpoints, endpoint);
+
+  if (self->priv->endpoint_paths != NULL)
+    g_ptr_array_add (self->priv->endpoint_paths,
+        (gpointer) tpy_call_stream_endpoint_get_object_path (endpoint));
+
+  tpy_dbus_properties_queue_changed (G_OBJECT (self),
+      TPY_IFACE_CALL_STREAM_INTERFACE_MEDIA, "Endpoints");
 }
 
 GList *
@@ -258,6 +420,8 @@ tpy_base_media_call_stream_set_stun_servers (TpyBaseMediaCallStream *self,
 
   tpy_svc_call_stream_interface_media_emit_stun_servers_changed (
       self, stun_servers);
+  tpy_dbus_properties_queue_changed (G_OBJECT (self),
+      TPY_IFACE_CALL_STREAM_INTERFACE_MEDIA, "STUNServers");
 }
 
 const gchar *tpy_base_media_call_stream_get_username (
@@ -296,13 +460,13 @@ tpy_base_media_call_stream_class_init (
       TPY_BASE_CALL_STREAM_CLASS (tpy_base_media_call_stream_class);
 
   static TpDBusPropertiesMixinPropImpl stream_media_props[] = {
-    { "Transport", "transport", NULL },
-    { "LocalCandidates", "local-candidates", NULL },
-    { "LocalCredentials", "local-credentials", NULL },
-    { "STUNServers", "stun-servers", NULL },
-    { "RelayInfo", "relay-info", NULL },
-    { "HasServerInfo", "has-server-info", NULL },
-    { "Endpoints", "endpoints", NULL },
+    { "Transport", GUINT_TO_POINTER (PROP_TRANSPORT), NULL },
+    { "LocalCandidates", GUINT_TO_POINTER (PROP_LOCAL_CANDIDATES), NULL },
+    { "LocalCredentials", GUINT_TO_POINTER (PROP_LOCAL_CREDENTIALS), NULL },
+    { "STUNServers", GUINT_TO_POINTER (PROP_STUN_SERVERS), NULL },
+    { "RelayInfo", GUINT_TO_POINTER (PROP_RELAY_INFO), NULL },
+    { "HasServerInfo", GUINT_TO_POINTER (PROP_HAS_SERVER_INFO), NULL },
+    { "Endpoints", GUINT_TO_POINTER (PROP_ENDPOINTS), NULL },
     { NULL }
   };
 
@@ -372,9 +536,27 @@ tpy_base_media_call_stream_class_init (
   g_object_class_install_property (object_class, PROP_HAS_SERVER_INFO,
       param_spec);
 
+  /* With the defaults (1 and 0) every AddCandidates call is signalled
+   * immediately */
+  param_spec = g_param_spec_uint ("candidate-batch-size",
+      "Candidate batch size",
+      "Number of local candidates to signal at once, 0 for unlimited",
+      0, G_MAXUINT, 1,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (object_class, PROP_CANDIDATE_BATCH_SIZE,
+      param_spec);
+
+  param_spec = g_param_spec_uint ("candidate-batch-latency",
+      "Candidate batch latency",
+      "Maximum time in ms before queued local candidates are signalled",
+      0, G_MAXUINT, 0,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (object_class,
+      PROP_CANDIDATE_BATCH_LATENCY, param_spec);
+
   tp_dbus_properties_mixin_implement_interface (object_class,
       TPY_IFACE_QUARK_CALL_STREAM_INTERFACE_MEDIA,
-      tp_dbus_properties_mixin_getter_gobject_properties,
+      tpy_base_media_call_stream_get_dbus_property,
       NULL,
       stream_media_props);
 
@@ -393,11 +575,18 @@ tpy_base_media_call_stream_dispose (GObject *object)
 
   priv->dispose_has_run = TRUE;
 
+  if (priv->candidates_flush_id != 0)
+    {
+      g_source_remove (priv->candidates_flush_id);
+      priv->candidates_flush_id = 0;
+    }
+
   for (l = priv->endpoints; l != NULL; l = g_list_next (l))
     {
       g_object_unref (l->data);
     }
 
+  tp_clear_pointer (&priv->endpoint_paths, g_ptr_array_unref);
   tp_clear_pointer (&priv->endpoints, g_list_free);
 
   if (G_OBJECT_CLASS (tpy_base_media_call_stream_parent_class)->dispose)
@@ -410,7 +599,9 @@ tpy_base_media_call_stream_finalize (GObject *object)
   TpyBaseMediaCallStream *self = TPY_BASE_MEDIA_CALL_STREAM (object);
   TpyBaseMediaCallStreamPrivate *priv = self->priv;
 
-  g_boxed_free (TPY_ARRAY_TYPE_CANDIDATE_LIST, priv->local_candidates);
+  g_ptr_array_unref (priv->local_candidates);
+  clear_pending_candidates (self);
+  g_ptr_array_unref (priv->pending_candidates);
   g_boxed_free (TP_ARRAY_TYPE_STRING_VARIANT_MAP_LIST, priv->relay_info);
   g_boxed_free (TP_ARRAY_TYPE_SOCKET_ADDRESS_IP_LIST, priv->stun_servers);
 
@@ -440,12 +631,40 @@ tpy_base_media_call_stream_add_candidates (
   if (error != NULL)
     goto except;
 
-  for (i = 0; i < accepted_candidates->len; i++)
-      g_ptr_array_add (self->priv->local_candidates,
-          g_ptr_array_index (accepted_candidates, i));
+  if (candidates_batched (self))
+    {
+      base_media_call_stream_queue_local_candidates (self,
+          accepted_candidates);
+      tpy_svc_call_stream_interface_media_return_from_add_candidates (
+          context);
+      goto finally;
+    }
 
-  tpy_svc_call_stream_interface_media_emit_local_candidates_added (self,
-      accepted_candidates);
+  for (i = 0; i < accepted_candidates->len; )
+    {
+      TpyCallStreamCandidate *c =
+          tpy_call_stream_candidate_new_from_value_array (
+              g_ptr_array_index (accepted_candidates, i));
+
+      if (c == NULL)
+        {
+          /* invalid, so neither stored nor signalled */
+          g_value_array_free (g_ptr_array_index (accepted_candidates, i));
+          g_ptr_array_remove_index (accepted_candidates, i);
+          continue;
+        }
+
+      g_ptr_array_add (self->priv->local_candidates, c);
+      i++;
+    }
+
+  if (accepted_candidates->len > 0)
+    {
+      tpy_svc_call_stream_interface_media_emit_local_candidates_added (self,
+          accepted_candidates);
+      tpy_dbus_properties_queue_changed (G_OBJECT (self),
+          TPY_IFACE_CALL_STREAM_INTERFACE_MEDIA, "LocalCandidates");
+    }
 
   tpy_svc_call_stream_interface_media_return_from_add_candidates (context);
 
@@ -455,10 +674,10 @@ except:
   dbus_g_method_return_error (context, error);
   g_clear_error (&error);
 finally:
-  /* Note that we only do a shallow free because we've copied the contents into
-   * local_candidates. */
+  /* local_candidates only keeps the native form of the candidates, so the
+   * accepted ones (which are ours) can go now they've been signalled. */
   if (accepted_candidates != NULL)
-    g_ptr_array_free (accepted_candidates, TRUE);
+    g_boxed_free (TPY_ARRAY_TYPE_CANDIDATE_LIST, accepted_candidates);
 }
 
 static void
@@ -470,6 +689,8 @@ tpy_base_media_call_stream_candidates_prepared (
   TpyBaseMediaCallStreamClass *klass =
       TPY_BASE_MEDIA_CALL_STREAM_GET_CLASS (self);
 
+  base_media_call_stream_flush_local_candidates (self);
+
   if (klass->local_candidates_prepared != NULL)
     klass->local_candidates_prepared (self);
 
@@ -491,13 +712,18 @@ tpy_base_media_call_stream_set_credentials (
   g_free (self->priv->password);
   self->priv->password = g_strdup (password);
 
-  g_boxed_free (TPY_ARRAY_TYPE_CANDIDATE_LIST, self->priv->local_candidates);
-  self->priv->local_candidates = g_ptr_array_new ();
+  /* Candidates still queued were gathered with the old credentials */
+  clear_pending_candidates (self);
+  g_ptr_array_set_size (self->priv->local_candidates, 0);
 
   g_object_notify (G_OBJECT (self), "local-candidates");
   g_object_notify (G_OBJECT (self), "local-credentials");
   tpy_svc_call_stream_interface_media_emit_local_credentials_changed (self,
       username, password);
+  tpy_dbus_properties_queue_changed (G_OBJECT (self),
+      TPY_IFACE_CALL_STREAM_INTERFACE_MEDIA, "LocalCandidates");
+  tpy_dbus_properties_queue_changed (G_OBJECT (self),
+      TPY_IFACE_CALL_STREAM_INTERFACE_MEDIA, "LocalCredentials");
 
   tpy_svc_call_stream_interface_media_return_from_set_credentials (context);
 }
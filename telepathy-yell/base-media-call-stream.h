@@ -32,6 +32,8 @@ typedef struct _TpyBaseMediaCallStream TpyBaseMediaCallStream;
 typedef struct _TpyBaseMediaCallStreamPrivate TpyBaseMediaCallStreamPrivate;
 typedef struct _TpyBaseMediaCallStreamClass TpyBaseMediaCallStreamClass;
 typedef void (*TpyBaseMediaStreamFunc) (TpyBaseMediaCallStream *self);
+/* Returns the accepted candidates as a new TPY_ARRAY_TYPE_CANDIDATE_LIST,
+ * which is freed (deeply) by the base class */
 typedef GPtrArray *(*TpyMediaStreamAddCandidatesFunc) (
     TpyBaseMediaCallStream *self,
     const GPtrArray *candidates,
@@ -80,8 +80,21 @@ struct _TpyCallChannelPrivate
 
   /* Array of TpyCallContents */
   GPtrArray *contents;
-
-  GSimpleAsyncResult *result;
+  /* Object path => borrowed TpyCallContent, for the same contents */
+  GHashTable *content_index;
+  /* Set of paths of contents created from the channel-properties but not
+   * (yet) confirmed by GetAll or ContentAdded */
+  GHashTable *unconfirmed_contents;
+
+  /* Streams of video contents => the TpySendingState they're counted under
+   * in video_stream_counts, from which video_state is derived */
+  GHashTable *video_streams;
+  guint video_stream_counts[NUM_TPY_SENDING_STATES];
+  TpySendingState video_state;
+
+  gboolean prefetch;
+  gint64 construct_time;
+  guint64 time_to_ready;
 
   gboolean properties_retrieved;
   gboolean ready;
@@ -102,7 +115,10 @@ enum /* props */
   PROP_INITIAL_VIDEO,
   PROP_INITIAL_VIDEO_NAME,
   PROP_MUTABLE_CONTENTS,
-  PROP_READY
+  PROP_READY,
+  PROP_PREFETCH,
+  PROP_TIME_TO_READY,
+  PROP_VIDEO_STATE
 };
 
 enum /* signals */
@@ -139,28 +155,186 @@ maybe_go_to_ready (TpyCallChannel *self)
         return;
     }
 
+  priv->time_to_ready = g_get_monotonic_time () - priv->construct_time;
+  DEBUG ("Ready after %" G_GUINT64_FORMAT " us", priv->time_to_ready);
+
   priv->ready = TRUE;
+  g_object_notify (G_OBJECT (self), "time-to-ready");
   g_object_notify (G_OBJECT (self), "ready");
 }
 
+static TpySendingState
+stream_sending_state (TpyCallStream *stream)
+{
+  TpySendingState state = tpy_call_stream_get_local_sending_state (stream);
+
+  if (state >= NUM_TPY_SENDING_STATES)
+    return TPY_SENDING_STATE_NONE;
+
+  return state;
+}
+
+static void
+update_video_state (TpyCallChannel *self)
+{
+  TpyCallChannelPrivate *priv = self->priv;
+  TpySendingState state = TPY_SENDING_STATE_NONE;
+
+  /* Streams pending stop sending don't count towards the video state */
+  if (priv->video_stream_counts[TPY_SENDING_STATE_SENDING] > 0)
+    state = TPY_SENDING_STATE_SENDING;
+  else if (priv->video_stream_counts[TPY_SENDING_STATE_PENDING_SEND] > 0)
+    state = TPY_SENDING_STATE_PENDING_SEND;
+
+  if (state == priv->video_state)
+    return;
+
+  priv->video_state = state;
+  g_object_notify (G_OBJECT (self), "video-state");
+}
+
+static void
+on_video_stream_sending_state_cb (TpyCallStream *stream,
+    GParamSpec *spec,
+    TpyCallChannel *self)
+{
+  TpyCallChannelPrivate *priv = self->priv;
+  TpySendingState state = stream_sending_state (stream);
+  gpointer old;
+
+  if (!g_hash_table_lookup_extended (priv->video_streams, stream, NULL, &old))
+    return;
+
+  priv->video_stream_counts[GPOINTER_TO_UINT (old)]--;
+  priv->video_stream_counts[state]++;
+  g_hash_table_insert (priv->video_streams, stream, GUINT_TO_POINTER (state));
+
+  update_video_state (self);
+}
+
+static void
+track_video_stream (TpyCallChannel *self,
+    TpyCallStream *stream)
+{
+  TpyCallChannelPrivate *priv = self->priv;
+  TpySendingState state;
+
+  if (g_hash_table_lookup_extended (priv->video_streams, stream, NULL, NULL))
+    return;
+
+  state = stream_sending_state (stream);
+  priv->video_stream_counts[state]++;
+  g_hash_table_insert (priv->video_streams, stream, GUINT_TO_POINTER (state));
+
+  tp_g_signal_connect_object (stream, "notify::local-sending-state",
+      G_CALLBACK (on_video_stream_sending_state_cb), self, 0);
+}
+
+static void
+untrack_video_stream (TpyCallChannel *self,
+    TpyCallStream *stream)
+{
+  TpyCallChannelPrivate *priv = self->priv;
+  gpointer old;
+
+  if (!g_hash_table_lookup_extended (priv->video_streams, stream, NULL, &old))
+    return;
+
+  priv->video_stream_counts[GPOINTER_TO_UINT (old)]--;
+  g_hash_table_remove (priv->video_streams, stream);
+
+  g_signal_handlers_disconnect_by_func (stream,
+      on_video_stream_sending_state_cb, self);
+}
+
+/* The media type is only known once the content has its properties, so
+ * this is done both when streams are added and when the content is ready */
+static void
+track_content_streams (TpyCallChannel *self,
+    TpyCallContent *content)
+{
+  GList *l;
+
+  if (tpy_call_content_get_media_type (content) != TP_MEDIA_STREAM_TYPE_VIDEO)
+    return;
+
+  for (l = tpy_call_content_get_streams (content); l != NULL;
+      l = g_list_next (l))
+    track_video_stream (self, l->data);
+
+  update_video_state (self);
+}
+
+static void
+on_content_streams_added_cb (TpyCallContent *content,
+    GPtrArray *streams,
+    TpyCallChannel *self)
+{
+  guint i;
+
+  if (tpy_call_content_get_media_type (content) != TP_MEDIA_STREAM_TYPE_VIDEO)
+    return;
+
+  for (i = 0; i < streams->len; i++)
+    track_video_stream (self, g_ptr_array_index (streams, i));
+
+  update_video_state (self);
+}
+
+static void
+on_content_streams_removed_cb (TpyCallContent *content,
+    GPtrArray *streams,
+    TpyCallChannel *self)
+{
+  guint i;
+
+  for (i = 0; i < streams->len; i++)
+    untrack_video_stream (self, g_ptr_array_index (streams, i));
+
+  update_video_state (self);
+}
+
 static void
 on_content_ready_cb (TpyCallContent *content,
   GParamSpec *spec,
   TpyCallChannel *self)
 {
+  track_content_streams (self, content);
   maybe_go_to_ready (self);
 }
 
+static TpyCallContent *
+find_content (TpyCallChannel *self,
+    const gchar *content_path)
+{
+  return g_hash_table_lookup (self->priv->content_index, content_path);
+}
+
 static void
-on_content_added_cb (TpProxy *proxy,
-    const gchar *content_path,
-    gpointer user_data,
-    GObject *weak_object)
+remove_content (TpyCallChannel *self,
+    TpyCallContent *content)
 {
-  TpyCallChannel *self = TPY_CALL_CHANNEL (proxy);
-  TpyCallContent *content;
+  GList *l;
 
-  DEBUG ("Content added: %s", content_path);
+  for (l = tpy_call_content_get_streams (content); l != NULL;
+      l = g_list_next (l))
+    untrack_video_stream (self, l->data);
+
+  update_video_state (self);
+
+  g_signal_handlers_disconnect_by_data (content, self);
+  g_hash_table_remove (self->priv->content_index,
+      tp_proxy_get_object_path (content));
+  g_ptr_array_remove (self->priv->contents, content);
+}
+
+/* The new content's own GetAll goes out as soon as it is constructed, so
+ * contents are fetched in parallel with each other and with the channel. */
+static TpyCallContent *
+add_content (TpyCallChannel *self,
+    const gchar *content_path)
+{
+  TpyCallContent *content;
 
   content = g_object_new (TPY_TYPE_CALL_CONTENT,
           "bus-name", tp_proxy_get_bus_name (self),
@@ -172,12 +346,50 @@ on_content_added_cb (TpProxy *proxy,
   if (content == NULL)
     {
       g_warning ("Could not create a CallContent for path %s", content_path);
-      return;
+      return NULL;
     }
 
   g_ptr_array_add (self->priv->contents, content);
+  g_hash_table_insert (self->priv->content_index,
+      (gchar *) tp_proxy_get_object_path (content), content);
   tp_g_signal_connect_object (content, "notify::ready",
     G_CALLBACK (on_content_ready_cb), self, 0);
+  tp_g_signal_connect_object (content, "streams-added",
+    G_CALLBACK (on_content_streams_added_cb), self, 0);
+  tp_g_signal_connect_object (content, "streams-removed",
+    G_CALLBACK (on_content_streams_removed_cb), self, 0);
+
+  return content;
+}
+
+static void
+on_content_added_cb (TpProxy *proxy,
+    const gchar *content_path,
+    gpointer user_data,
+    GObject *weak_object)
+{
+  TpyCallChannel *self = TPY_CALL_CHANNEL (proxy);
+  TpyCallContent *content;
+
+  DEBUG ("Content added: %s", content_path);
+
+  content = find_content (self, content_path);
+
+  if (content != NULL)
+    {
+      /* Either prefetched, in which case this is the first time it's
+       * announced, or already picked up by GetAll */
+      if (!g_hash_table_remove (self->priv->unconfirmed_contents,
+              content_path))
+        return;
+    }
+  else
+    {
+      content = add_content (self, content_path);
+
+      if (content == NULL)
+        return;
+    }
 
   g_signal_emit (self, _signals[CONTENT_ADDED], 0, content);
 }
@@ -189,25 +401,17 @@ on_content_removed_cb (TpProxy *proxy,
     GObject *weak_object)
 {
   TpyCallChannel *self = TPY_CALL_CHANNEL (proxy);
-  TpyCallContent *content = NULL, *c;
-  guint i;
+  TpyCallContent *content;
 
   DEBUG ("Content removed: %s", content_path);
 
-  for (i = 0; i < self->priv->contents->len; i++)
-    {
-      c = g_ptr_array_index (self->priv->contents, i);
-      if (g_strcmp0 (tp_proxy_get_object_path (c), content_path) == 0)
-        {
-          content = c;
-          break;
-        }
-    }
+  content = find_content (self, content_path);
 
   if (content != NULL)
     {
+      g_hash_table_remove (self->priv->unconfirmed_contents, content_path);
       g_signal_emit (self, _signals[CONTENT_REMOVED], 0, content);
-      g_ptr_array_remove (self->priv->contents, content);
+      remove_content (self, content);
     }
   else
     {
@@ -223,12 +427,20 @@ on_call_members_changed_cb (TpProxy *proxy,
     GObject *weak_object)
 {
   TpyCallChannel *self = TPY_CALL_CHANNEL (proxy);
+  GHashTableIter iter;
+  gpointer key, value;
+  guint i;
+
+  DEBUG ("Call members changed: %d changed, %d removed",
+      g_hash_table_size (flags_changed), removed->len);
 
-  DEBUG ("Call members changed: %d members",
-      g_hash_table_size (flags_changed));
+  for (i = 0; i < removed->len; i++)
+    g_hash_table_remove (self->priv->members,
+        GUINT_TO_POINTER (g_array_index (removed, TpHandle, i)));
 
-  g_hash_table_unref (self->priv->members);
-  self->priv->members = g_hash_table_ref (flags_changed);
+  g_hash_table_iter_init (&iter, flags_changed);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    g_hash_table_insert (self->priv->members, key, value);
 
   g_signal_emit (self, _signals[MEMBERS_CHANGED], 0, self->priv->members);
 }
@@ -266,6 +478,8 @@ on_call_channel_get_all_properties_cb (TpProxy *proxy,
   TpyCallChannel *self = TPY_CALL_CHANNEL (proxy);
   GHashTable *hash_table;
   GPtrArray *contents;
+  GHashTableIter iter;
+  gpointer key, value;
   guint i;
 
   if (error != NULL)
@@ -292,36 +506,38 @@ on_call_channel_get_all_properties_cb (TpProxy *proxy,
   hash_table = tp_asv_get_boxed (properties,
       "CallMembers", TPY_HASH_TYPE_CALL_MEMBER_MAP);
   if (hash_table != NULL)
-    self->priv->members = g_boxed_copy (TPY_HASH_TYPE_CALL_MEMBER_MAP,
-        hash_table);
+    {
+      g_hash_table_unref (self->priv->members);
+      self->priv->members = g_boxed_copy (TPY_HASH_TYPE_CALL_MEMBER_MAP,
+          hash_table);
+    }
 
   contents = tp_asv_get_boxed (properties,
       "Contents", TP_ARRAY_TYPE_OBJECT_PATH_LIST);
 
-  for (i = 0; i < contents->len; i++)
+  for (i = 0; contents != NULL && i < contents->len; i++)
     {
       const gchar *content_path = g_ptr_array_index (contents, i);
-      TpyCallContent *content;
-
-      DEBUG ("Content added: %s", content_path);
-
-      content = g_object_new (TPY_TYPE_CALL_CONTENT,
-              "bus-name", tp_proxy_get_bus_name (self),
-              "dbus-daemon", tp_proxy_get_dbus_daemon (self),
-              "dbus-connection", tp_proxy_get_dbus_connection (self),
-              "object-path", content_path,
-              NULL);
 
-      if (content == NULL)
+      /* Already prefetched, or added by ContentAdded in the meantime */
+      if (find_content (self, content_path) != NULL)
         {
-          g_warning ("Could not create a CallContent for path %s", content_path);
-          return;
+          g_hash_table_remove (self->priv->unconfirmed_contents,
+              content_path);
+          continue;
         }
 
-      g_ptr_array_add (self->priv->contents, content);
+      DEBUG ("Content added: %s", content_path);
+      add_content (self, content_path);
+    }
 
-      tp_g_signal_connect_object (content, "notify::ready",
-        G_CALLBACK (on_content_ready_cb), self, 0);
+  /* Anything prefetched that GetAll doesn't know about was stale */
+  g_hash_table_iter_init (&iter, self->priv->unconfirmed_contents);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      DEBUG ("Dropping stale prefetched content %s", (gchar *) key);
+      g_hash_table_iter_remove (&iter);
+      remove_content (self, value);
     }
 
   g_signal_emit (self, _signals[MEMBERS_CHANGED], 0, self->priv->members);
@@ -336,10 +552,26 @@ tpy_call_channel_dispose (GObject *obj)
 {
   TpyCallChannel *self = (TpyCallChannel *) obj;
 
+  if (self->priv->video_streams != NULL)
+    {
+      GHashTableIter iter;
+      gpointer stream;
+
+      /* the streams may outlive us, and notify until we are finalized */
+      g_hash_table_iter_init (&iter, self->priv->video_streams);
+      while (g_hash_table_iter_next (&iter, &stream, NULL))
+        g_signal_handlers_disconnect_by_func (stream,
+            on_video_stream_sending_state_cb, self);
+
+      g_hash_table_unref (self->priv->video_streams);
+      self->priv->video_streams = NULL;
+    }
+
+  tp_clear_pointer (&self->priv->unconfirmed_contents, g_hash_table_unref);
+  tp_clear_pointer (&self->priv->content_index, g_hash_table_unref);
   tp_clear_pointer (&self->priv->contents, g_ptr_array_unref);
   tp_clear_pointer (&self->priv->details, g_hash_table_unref);
-
-  tp_clear_object (&self->priv->result);
+  tp_clear_pointer (&self->priv->members, g_hash_table_unref);
 
   G_OBJECT_CLASS (tpy_call_channel_parent_class)->dispose (obj);
 }
@@ -386,12 +618,77 @@ tpy_call_channel_get_property (GObject *object,
         g_value_set_boolean (value, self->priv->ready);
         break;
 
+      case PROP_PREFETCH:
+        g_value_set_boolean (value, self->priv->prefetch);
+        break;
+
+      case PROP_TIME_TO_READY:
+        g_value_set_uint64 (value, self->priv->time_to_ready);
+        break;
+
+      case PROP_VIDEO_STATE:
+        g_value_set_uint (value, self->priv->video_state);
+        break;
+
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
         break;
     }
 }
 
+static void
+tpy_call_channel_set_property (GObject *object,
+    guint property_id,
+    const GValue *value,
+    GParamSpec *pspec)
+{
+  TpyCallChannel *self = (TpyCallChannel *) object;
+
+  switch (property_id)
+    {
+      case PROP_PREFETCH:
+        self->priv->prefetch = g_value_get_boolean (value);
+        break;
+
+      default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+        break;
+    }
+}
+
+/* Contents announced in the channel-properties can be fetched straight away,
+ * rather than after the channel's own GetAll returns */
+static void
+prefetch_contents (TpyCallChannel *self)
+{
+  GHashTable *props;
+  GPtrArray *contents;
+  guint i;
+
+  props = tp_channel_borrow_immutable_properties (TP_CHANNEL (self));
+  contents = tp_asv_get_boxed (props, TPY_PROP_CHANNEL_TYPE_CALL_CONTENTS,
+      TP_ARRAY_TYPE_OBJECT_PATH_LIST);
+
+  if (contents == NULL)
+    return;
+
+  for (i = 0; i < contents->len; i++)
+    {
+      const gchar *content_path = g_ptr_array_index (contents, i);
+      TpyCallContent *content;
+
+      if (find_content (self, content_path) != NULL)
+        continue;
+
+      DEBUG ("Prefetching content %s", content_path);
+      content = add_content (self, content_path);
+
+      if (content != NULL)
+        g_hash_table_insert (self->priv->unconfirmed_contents,
+            (gchar *) tp_proxy_get_object_path (content), content);
+    }
+}
+
 static void
 tpy_call_channel_constructed (GObject *obj)
 {
@@ -399,6 +696,8 @@ tpy_call_channel_constructed (GObject *obj)
   TpChannel *chan = (TpChannel *) obj;
   GError *err = NULL;
 
+  self->priv->construct_time = g_get_monotonic_time ();
+
   ((GObjectClass *) tpy_call_channel_parent_class)->constructed (obj);
 
   if (tp_channel_get_channel_type_id (chan) !=
@@ -464,6 +763,9 @@ tpy_call_channel_constructed (GObject *obj)
   tp_cli_dbus_properties_call_get_all (self, -1,
       TPY_IFACE_CHANNEL_TYPE_CALL,
       on_call_channel_get_all_properties_cb, NULL, NULL, NULL);
+
+  if (self->priv->prefetch)
+    prefetch_contents (self);
 }
 
 static void
@@ -474,6 +776,7 @@ tpy_call_channel_class_init (TpyCallChannelClass *klass)
 
   gobject_class->constructed = tpy_call_channel_constructed;
   gobject_class->get_property = tpy_call_channel_get_property;
+  gobject_class->set_property = tpy_call_channel_set_property;
   gobject_class->dispose = tpy_call_channel_dispose;
 
   g_type_class_add_private (klass, sizeof (TpyCallChannelPrivate));
@@ -588,6 +891,52 @@ tpy_call_channel_class_init (TpyCallChannelClass *klass)
   g_object_class_install_property (gobject_class, PROP_READY,
       param_spec);
 
+  /**
+   * TpyCallChannel:prefetch:
+   *
+   * If %TRUE, contents listed in the channel's immutable properties are
+   * fetched immediately, in parallel with the channel's own properties.
+   *
+   * Since:
+   */
+  param_spec = g_param_spec_boolean ("prefetch", "Prefetch",
+      "Whether to fetch known contents before the channel properties",
+      FALSE,
+      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (gobject_class, PROP_PREFETCH,
+      param_spec);
+
+  /**
+   * TpyCallChannel:time-to-ready:
+   *
+   * The time in microseconds it took from constructing the channel until
+   * it and all its contents and streams were ready, or 0 if it's not
+   * ready yet.
+   *
+   * Since:
+   */
+  param_spec = g_param_spec_uint64 ("time-to-ready", "Time to ready",
+      "Microseconds between construction and readiness",
+      0, G_MAXUINT64, 0,
+      G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (gobject_class, PROP_TIME_TO_READY,
+      param_spec);
+
+  /**
+   * TpyCallChannel:video-state:
+   *
+   * The #TpySendingState of the video contents of this call, see
+   * tpy_call_channel_get_video_state().
+   *
+   * Since:
+   */
+  param_spec = g_param_spec_uint ("video-state", "Video state",
+      "The sending state of the video streams of this call",
+      0, NUM_TPY_SENDING_STATES - 1, TPY_SENDING_STATE_NONE,
+      G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (gobject_class, PROP_VIDEO_STATE,
+      param_spec);
+
   /**
    * TpyCallChannel::content-added
    * @self: the #TpyCallChannel
@@ -665,6 +1014,11 @@ tpy_call_channel_init (TpyCallChannel *self)
       TPY_TYPE_CALL_CHANNEL, TpyCallChannelPrivate);
 
   self->priv->contents = g_ptr_array_new_with_free_func (g_object_unref);
+  self->priv->content_index = g_hash_table_new (g_str_hash, g_str_equal);
+  self->priv->video_streams = g_hash_table_new (NULL, NULL);
+  self->priv->unconfirmed_contents = g_hash_table_new (g_str_hash,
+      g_str_equal);
+  self->priv->members = g_hash_table_new (g_direct_hash, g_direct_equal);
 }
 
 /**
@@ -715,18 +1069,20 @@ channel_accept_cb (TpProxy *proxy,
     gpointer user_data,
     GObject *weak_object)
 {
-  TpyCallChannel *self = TPY_CALL_CHANNEL (proxy);
+  GSimpleAsyncResult *result = user_data;
 
   if (error != NULL)
     {
       DEBUG ("Failed to accept call: %s", error->message);
 
-      g_simple_async_result_set_from_error (self->priv->result, error);
+      g_simple_async_result_set_from_error (result, error);
+    }
+  else
+    {
+      g_simple_async_result_set_op_res_gboolean (result, TRUE);
     }
 
-  g_simple_async_result_set_op_res_gboolean (self->priv->result, TRUE);
-  g_simple_async_result_complete (self->priv->result);
-  tp_clear_object (&self->priv->result);
+  g_simple_async_result_complete (result);
 }
 
 /**
@@ -746,14 +1102,15 @@ tpy_call_channel_accept_async (TpyCallChannel *self,
     GAsyncReadyCallback callback,
     gpointer user_data)
 {
+  GSimpleAsyncResult *result;
+
   g_return_if_fail (TPY_IS_CALL_CHANNEL (self));
-  g_return_if_fail (self->priv->result == NULL);
 
-  self->priv->result = g_simple_async_result_new (G_OBJECT (self), callback,
+  result = g_simple_async_result_new (G_OBJECT (self), callback,
       user_data, tpy_call_channel_accept_async);
 
   tpy_cli_channel_type_call_call_accept (TP_PROXY (self), -1,
-      channel_accept_cb, NULL, NULL, G_OBJECT (self));
+      channel_accept_cb, result, g_object_unref, NULL);
 }
 
 /**
@@ -789,17 +1146,20 @@ channel_hangup_cb (TpProxy *proxy,
     gpointer user_data,
     GObject *weak_object)
 {
-  TpyCallChannel *self = TPY_CALL_CHANNEL (proxy);
+  GSimpleAsyncResult *result = user_data;
 
   if (error != NULL)
     {
       DEBUG ("Failed to hang up: %s", error->message);
 
-      g_simple_async_result_set_from_error (self->priv->result, error);
+      g_simple_async_result_set_from_error (result, error);
+    }
+  else
+    {
+      g_simple_async_result_set_op_res_gboolean (result, TRUE);
     }
 
-  g_simple_async_result_complete (self->priv->result);
-  tp_clear_object (&self->priv->result);
+  g_simple_async_result_complete (result);
 }
 
 void
@@ -810,22 +1170,53 @@ tpy_call_channel_hangup_async (TpyCallChannel *self,
     GAsyncReadyCallback callback,
     gpointer user_data)
 {
+  GSimpleAsyncResult *result;
+
   g_return_if_fail (TPY_IS_CALL_CHANNEL (self));
-  g_return_if_fail (self->priv->result == NULL);
 
-  self->priv->result = g_simple_async_result_new (G_OBJECT (self), callback,
-      user_data, tpy_call_channel_accept_async);
+  result = g_simple_async_result_new (G_OBJECT (self), callback,
+      user_data, tpy_call_channel_hangup_async);
 
   tpy_cli_channel_type_call_call_hangup (TP_PROXY (self), -1,
       reason, detailed_reason, message,
-      channel_hangup_cb, NULL, NULL, G_OBJECT (self));
+      channel_hangup_cb, result, g_object_unref, NULL);
 }
 
-void
+gboolean
 tpy_call_channel_hangup_finish (TpyCallChannel *self,
     GAsyncResult *result,
     GError **error)
 {
+  if (g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (result),
+      error))
+    return FALSE;
+
+  g_return_val_if_fail (g_simple_async_result_is_valid (result,
+    G_OBJECT (self), tpy_call_channel_hangup_async),
+    FALSE);
+
+  return g_simple_async_result_get_op_res_gboolean (
+    G_SIMPLE_ASYNC_RESULT (result));
+}
+
+/**
+ * tpy_call_channel_lookup_content:
+ * @self: a #TpyCallChannel
+ * @object_path: the object path of a content
+ *
+ * Returns: (transfer none): the #TpyCallContent of @self with path
+ *  @object_path, or %NULL if there is none
+ *
+ * Since:
+ */
+TpyCallContent *
+tpy_call_channel_lookup_content (TpyCallChannel *self,
+    const gchar *object_path)
+{
+  g_return_val_if_fail (TPY_IS_CALL_CHANNEL (self), NULL);
+  g_return_val_if_fail (object_path != NULL, NULL);
+
+  return find_content (self, object_path);
 }
 
 TpyCallState
@@ -901,41 +1292,23 @@ tpy_call_channel_send_video (TpyCallChannel *self,
         NULL, NULL, NULL, NULL);
 }
 
+/**
+ * tpy_call_channel_get_video_state:
+ * @self: a #TpyCallChannel
+ *
+ * Returns: the highest #TpySendingState of the streams of the video
+ *  contents of @self, ignoring streams pending stop sending
+ *
+ * Since:
+ */
 TpySendingState
 tpy_call_channel_get_video_state (TpyCallChannel *self)
 {
-  TpySendingState result = TPY_SENDING_STATE_NONE;
-  guint i;
-
   g_return_val_if_fail (TPY_IS_CALL_CHANNEL (self), TPY_SENDING_STATE_NONE);
 
-  for (i = 0 ; i < self->priv->contents->len ; i++)
-    {
-      TpyCallContent *content = g_ptr_array_index (self->priv->contents, i);
-
-      if (tpy_call_content_get_media_type (content)
-          == TP_MEDIA_STREAM_TYPE_VIDEO)
-        {
-          GList *l;
-
-          for (l = tpy_call_content_get_streams (content);
-              l != NULL ; l = g_list_next (l))
-            {
-              TpyCallStream *stream = TPY_CALL_STREAM (l->data);
-              TpySendingState state;
-
-              g_object_get (stream, "local-sending-state", &state, NULL);
-              if (state != TPY_SENDING_STATE_PENDING_STOP_SENDING &&
-                  state > result)
-                result = state;
-            }
-        }
-    }
-
-  return result;
+  return self->priv->video_state;
 }
 
-
 gboolean
 tpy_call_channel_has_dtmf (TpyCallChannel *self)
 {
@@ -75,7 +75,7 @@ void tpy_call_channel_hangup_async (TpyCallChannel *self,
     GAsyncReadyCallback callback,
     gpointer user_data);
 
-void tpy_call_channel_hangup_finish (TpyCallChannel *self,
+gboolean tpy_call_channel_hangup_finish (TpyCallChannel *self,
     GAsyncResult *result,
     GError **error);
 
@@ -102,6 +102,9 @@ void tpy_call_channel_send_video (TpyCallChannel *self,
 
 TpySendingState tpy_call_channel_get_video_state (TpyCallChannel *self);
 
+TpyCallContent *tpy_call_channel_lookup_content (TpyCallChannel *self,
+    const gchar *object_path);
+
 TpyCallState tpy_call_channel_get_state (TpyCallChannel *self,
     TpyCallFlags *flags, GHashTable **details);
 
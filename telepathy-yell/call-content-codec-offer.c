@@ -269,6 +269,7 @@ tpy_call_content_codec_offer_accept (TpySvcCallContentCodecOffer *iface,
 {
   TpyCallContentCodecOffer *self = TPY_CALL_CONTENT_CODEC_OFFER (iface);
   TpyCallContentCodecOfferPrivate *priv = self->priv;
+  GSimpleAsyncResult *result;
 
   g_return_if_fail (priv->bus != NULL);
 
@@ -282,15 +283,18 @@ tpy_call_content_codec_offer_accept (TpySvcCallContentCodecOffer *iface,
       priv->handler_id = 0;
     }
 
-  g_simple_async_result_set_op_res_gpointer (priv->result,
-    (gpointer) codecs, NULL);
-  g_simple_async_result_complete (priv->result);
-  g_object_unref (priv->result);
+  /* Be done with the offer before completing, so that it can be reused
+   * from the callback. The reply goes first, so the streaming engine has it
+   * before any offer that completing this one starts. */
+  result = priv->result;
   priv->result = NULL;
+  tp_dbus_daemon_unregister_object (priv->bus, G_OBJECT (self));
 
   tpy_svc_call_content_codec_offer_return_from_accept (context);
 
-  tp_dbus_daemon_unregister_object (priv->bus, G_OBJECT (self));
+  g_simple_async_result_set_op_res_gpointer (result, (gpointer) codecs, NULL);
+  g_simple_async_result_complete (result);
+  g_object_unref (result);
 }
 
 static void
@@ -299,6 +303,7 @@ tpy_call_content_codec_offer_reject (TpySvcCallContentCodecOffer *iface,
 {
   TpyCallContentCodecOffer *self = TPY_CALL_CONTENT_CODEC_OFFER (iface);
   TpyCallContentCodecOfferPrivate *priv = self->priv;
+  GSimpleAsyncResult *result;
 
   g_return_if_fail (priv->bus != NULL);
 
@@ -312,15 +317,16 @@ tpy_call_content_codec_offer_reject (TpySvcCallContentCodecOffer *iface,
       priv->handler_id = 0;
     }
 
-  g_simple_async_result_set_error (priv->result,
-      G_IO_ERROR, G_IO_ERROR_FAILED, "Codec offer was rejected");
-  g_simple_async_result_complete (priv->result);
-  g_object_unref (priv->result);
+  result = priv->result;
   priv->result = NULL;
+  tp_dbus_daemon_unregister_object (priv->bus, G_OBJECT (self));
 
   tpy_svc_call_content_codec_offer_return_from_reject (context);
 
-  tp_dbus_daemon_unregister_object (priv->bus, G_OBJECT (self));
+  g_simple_async_result_set_error (result,
+      G_IO_ERROR, G_IO_ERROR_FAILED, "Codec offer was rejected");
+  g_simple_async_result_complete (result);
+  g_object_unref (result);
 }
 
 static void
@@ -348,6 +354,34 @@ tpy_call_content_codec_offer_new (const gchar *object_path,
     NULL);
 }
 
+/**
+ * tpy_call_content_codec_offer_reset:
+ *
+ * Prepares a finished offer to be offered again at @object_path, for
+ * @remote_contact and @codecs. @object_path should not have been used by an
+ * earlier offer, so that late replies to that offer can't reach this one.
+ */
+void
+tpy_call_content_codec_offer_reset (TpyCallContentCodecOffer *offer,
+  const gchar *object_path,
+  TpHandle remote_contact,
+  GPtrArray *codecs)
+{
+  TpyCallContentCodecOfferPrivate *priv = offer->priv;
+
+  g_return_if_fail (priv->bus != NULL);
+  g_return_if_fail (priv->result == NULL);
+  g_return_if_fail (object_path != NULL);
+
+  g_free (priv->object_path);
+  priv->object_path = g_strdup (object_path);
+
+  if (priv->codecs != NULL)
+    g_boxed_free (TPY_ARRAY_TYPE_CODEC_LIST, priv->codecs);
+  priv->codecs = g_boxed_copy (TPY_ARRAY_TYPE_CODEC_LIST, codecs);
+  priv->contact = remote_contact;
+}
+
 static void
 cancelled_cb (GCancellable *cancellable, gpointer user_data)
 {
@@ -69,6 +69,11 @@ TpyCallContentCodecOffer *tpy_call_content_codec_offer_new (
   TpHandle remote_contact,
   GPtrArray *codecs);
 
+void tpy_call_content_codec_offer_reset (TpyCallContentCodecOffer *offer,
+  const gchar *object_path,
+  TpHandle remote_contact,
+  GPtrArray *codecs);
+
 void tpy_call_content_codec_offer_offer (TpyCallContentCodecOffer *offer,
   GCancellable *cancellable,
   GAsyncReadyCallback callback,
@@ -40,10 +40,10 @@ struct _TpyCallContentPrivate
   TpMediaStreamType media_type;
   TpyCallContentDisposition disposition;
   GList *streams;
+  /* Object path => link in streams */
+  GHashTable *stream_links;
   gboolean ready;
   gboolean properties_retrieved;
-
-  GSimpleAsyncResult *result;
 };
 
 enum
@@ -71,13 +71,6 @@ static void on_call_content_get_all_properties_cb (TpProxy *proxy,
     gpointer user_data,
     GObject *weak_object);
 
-static gint
-find_stream_for_object_path (gconstpointer a,
-    gconstpointer b)
-{
-  return g_strcmp0 (tp_proxy_get_object_path ((gpointer) a), b);
-}
-
 static void
 on_content_removed_cb (TpProxy *proxy,
     gpointer user_data,
@@ -139,6 +132,10 @@ add_streams (TpyCallContent *self, const GPtrArray *streams)
 
       object_path = g_ptr_array_index (streams, i);
 
+      /* StreamsAdded may have raced with GetAll */
+      if (g_hash_table_lookup (self->priv->stream_links, object_path) != NULL)
+        continue;
+
       stream = g_object_new (TPY_TYPE_CALL_STREAM,
           "bus-name", tp_proxy_get_bus_name (self),
           "dbus-daemon", tp_proxy_get_dbus_daemon (self),
@@ -156,6 +153,8 @@ add_streams (TpyCallContent *self, const GPtrArray *streams)
         G_CALLBACK (on_stream_ready_cb), self, 0);
 
       self->priv->streams = g_list_prepend (self->priv->streams, stream);
+      g_hash_table_insert (self->priv->stream_links,
+          (gchar *) tp_proxy_get_object_path (stream), self->priv->streams);
       g_ptr_array_add (object_streams, stream);
     }
 
@@ -194,9 +193,7 @@ on_streams_removed_cb (TpProxy *proxy,
 
       object_path = g_ptr_array_index (streams, i);
 
-      s = g_list_find_custom (self->priv->streams,
-          object_path,
-          find_stream_for_object_path);
+      s = g_hash_table_lookup (self->priv->stream_links, object_path);
 
       if (s == NULL)
         {
@@ -204,8 +201,9 @@ on_streams_removed_cb (TpProxy *proxy,
           continue;
         }
 
-      self->priv->streams = g_list_remove_link (self->priv->streams, s);
+      g_hash_table_remove (self->priv->stream_links, object_path);
       g_ptr_array_add (object_streams, s->data);
+      self->priv->streams = g_list_delete_link (self->priv->streams, s);
     }
 
   g_signal_emit (self, _signals[STREAMS_REMOVED], 0, object_streams);
@@ -269,6 +267,7 @@ tpy_call_content_init (TpyCallContent *self)
       TPY_TYPE_CALL_CONTENT, TpyCallContentPrivate);
 
   self->priv = priv;
+  priv->stream_links = g_hash_table_new (g_str_hash, g_str_equal);
 }
 
 static void
@@ -277,8 +276,8 @@ tpy_call_content_dispose (GObject *object)
   TpyCallContent *self = TPY_CALL_CONTENT (object);
 
   tp_clear_pointer (&self->priv->name, g_free);
-  tp_clear_object (&self->priv->result);
 
+  tp_clear_pointer (&self->priv->stream_links, g_hash_table_unref);
   g_list_free_full (self->priv->streams, g_object_unref);
   self->priv->streams = NULL;
 
@@ -507,18 +506,20 @@ on_content_remove_cb (TpProxy *proxy,
     gpointer user_data,
     GObject *weak_object)
 {
-  TpyCallContent *self = TPY_CALL_CONTENT (proxy);
+  GSimpleAsyncResult *result = user_data;
 
   if (error != NULL)
     {
       DEBUG ("Failed to remove content: %s", error->message);
 
-      g_simple_async_result_set_from_error (self->priv->result, error);
+      g_simple_async_result_set_from_error (result, error);
+    }
+  else
+    {
+      g_simple_async_result_set_op_res_gboolean (result, TRUE);
     }
 
-  g_simple_async_result_set_op_res_gboolean (self->priv->result, TRUE);
-  g_simple_async_result_complete (self->priv->result);
-  tp_clear_object (&self->priv->result);
+  g_simple_async_result_complete (result);
 }
 
 void
@@ -529,12 +530,19 @@ tpy_call_content_remove_async (TpyCallContent *self,
     GAsyncReadyCallback callback,
     gpointer user_data)
 {
+  GSimpleAsyncResult *result;
+
+  g_return_if_fail (TPY_IS_CALL_CONTENT (self));
+
   DEBUG ("removing content for reason %u, detailed reason: %s, message: %s",
       reason, detailed_removal_reason, message);
 
+  result = g_simple_async_result_new (G_OBJECT (self), callback,
+      user_data, tpy_call_content_remove_async);
+
   tpy_cli_call_content_call_remove (TP_PROXY (self), -1,
       reason, detailed_removal_reason, message,
-      on_content_remove_cb, NULL, NULL, G_OBJECT (self));
+      on_content_remove_cb, result, g_object_unref, NULL);
 }
 
 gboolean
@@ -559,3 +567,28 @@ tpy_call_content_get_streams (TpyCallContent *self)
 {
   return self->priv->streams;
 }
+
+/**
+ * tpy_call_content_lookup_stream:
+ * @self: a #TpyCallContent
+ * @object_path: the object path of a stream
+ *
+ * Returns: (transfer none): the #TpyCallStream of @self with path
+ *  @object_path, or %NULL if there is none. It is owned by @self, and only
+ *  valid until the stream is removed.
+ *
+ * Since:
+ */
+TpyCallStream *
+tpy_call_content_lookup_stream (TpyCallContent *self,
+    const gchar *object_path)
+{
+  GList *l;
+
+  g_return_val_if_fail (TPY_IS_CALL_CONTENT (self), NULL);
+  g_return_val_if_fail (object_path != NULL, NULL);
+
+  l = g_hash_table_lookup (self->priv->stream_links, object_path);
+
+  return l != NULL ? l->data : NULL;
+}
@@ -26,6 +26,7 @@
 #include <telepathy-glib/telepathy-glib.h>
 
 #include "enums.h"
+#include "call-stream.h"
 
 G_BEGIN_DECLS
 
@@ -71,6 +72,8 @@ TpyCallContentDisposition tpy_call_content_get_disposition (
     TpyCallContent *self);
 
 GList *tpy_call_content_get_streams (TpyCallContent *self);
+TpyCallStream *tpy_call_content_lookup_stream (TpyCallContent *self,
+    const gchar *object_path);
 
 void tpy_call_content_remove_async (TpyCallContent *self,
     TpyContentRemovalReason reason,
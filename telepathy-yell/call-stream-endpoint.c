@@ -32,6 +32,7 @@
 #include <telepathy-glib/util.h>
 
 #include <telepathy-yell/enums.h>
+#include <telepathy-yell/extensions.h>
 #include <telepathy-yell/interfaces.h>
 #include <telepathy-yell/gtypes.h>
 #include <telepathy-yell/svc-call.h>
@@ -61,6 +62,8 @@ enum
   PROP_SELECTED_CANDIDATE,
   PROP_STREAM_STATE,
   PROP_TRANSPORT,
+  PROP_CANDIDATE_BATCH_SIZE,
+  PROP_CANDIDATE_BATCH_LATENCY,
 };
 
 struct _TpyCallStreamEndpointPrivate
@@ -69,9 +72,16 @@ struct _TpyCallStreamEndpointPrivate
 
   TpDBusDaemon *dbus_daemon;
   gchar *object_path;
-  GValueArray *remote_credentials;
+  /* The candidate arrays are NULL until there are candidates; the D-Bus
+   * forms of the candidates and credentials are only built when read */
   GPtrArray *remote_candidates;
-  GValueArray *selected_candidate;
+  /* candidates added but not yet signalled */
+  GPtrArray *pending_candidates;
+  guint candidate_batch_size;
+  guint candidate_batch_latency;
+  guint candidates_flush_id;
+  /* NULL until one is selected */
+  TpyCallStreamCandidate *selected_candidate;
   TpMediaStreamState stream_state;
   TpyStreamTransportType transport;
 };
@@ -85,20 +95,21 @@ tpy_call_stream_endpoint_init (TpyCallStreamEndpoint *self)
 
   self->priv = priv;
 
-  priv->selected_candidate = tp_value_array_build (4,
-      G_TYPE_UINT, 0,
-      G_TYPE_STRING, "",
-      G_TYPE_UINT, 0,
-      TPY_HASH_TYPE_CANDIDATE_INFO,
-          g_hash_table_new (g_str_hash, g_str_equal),
-      G_TYPE_INVALID);
+  priv->candidate_batch_size = 1;
+}
+
+/* Takes ownership of @c */
+static void
+call_stream_endpoint_take_remote_candidate (TpyCallStreamEndpoint *self,
+    TpyCallStreamCandidate *c)
+{
+  TpyCallStreamEndpointPrivate *priv = self->priv;
 
-  priv->remote_credentials = tp_value_array_build (2,
-      G_TYPE_STRING, "",
-      G_TYPE_STRING, "",
-      G_TYPE_INVALID);
+  if (priv->remote_candidates == NULL)
+    priv->remote_candidates = g_ptr_array_new_with_free_func (
+        (GDestroyNotify) tpy_call_stream_candidate_free);
 
-  priv->remote_candidates = g_ptr_array_new ();
+  g_ptr_array_add (priv->remote_candidates, c);
 }
 
 static void tpy_call_stream_endpoint_dispose (GObject *object);
@@ -119,13 +130,34 @@ tpy_call_stream_endpoint_get_property (GObject    *object,
         g_value_set_string (value, priv->object_path);
         break;
       case PROP_REMOTE_CANDIDATES:
-        g_value_set_boxed (value, priv->remote_candidates);
+        if (priv->remote_candidates != NULL)
+          g_value_take_boxed (value,
+              tpy_call_stream_candidate_list_to_value_arrays (
+                  priv->remote_candidates));
+        else
+          g_value_take_boxed (value, g_ptr_array_new ());
         break;
       case PROP_REMOTE_CREDENTIALS:
-        g_value_set_boxed (value, priv->remote_credentials);
+        /* remote credentials are never set on endpoints */
+        g_value_take_boxed (value, tp_value_array_build (2,
+            G_TYPE_STRING, "",
+            G_TYPE_STRING, "",
+            G_TYPE_INVALID));
         break;
       case PROP_SELECTED_CANDIDATE:
-        g_value_set_boxed (value, priv->selected_candidate);
+        if (priv->selected_candidate != NULL)
+          {
+            g_value_take_boxed (value,
+                tpy_call_stream_candidate_to_value_array (
+                    priv->selected_candidate));
+          }
+        else
+          {
+            TpyCallStreamCandidate none = { 0, 0, "", NULL };
+
+            g_value_take_boxed (value,
+                tpy_call_stream_candidate_to_value_array (&none));
+          }
         break;
       case PROP_STREAM_STATE:
         g_value_set_uint (value, priv->stream_state);
@@ -133,12 +165,25 @@ tpy_call_stream_endpoint_get_property (GObject    *object,
       case PROP_TRANSPORT:
         g_value_set_uint (value, priv->transport);
         break;
+      case PROP_CANDIDATE_BATCH_SIZE:
+        g_value_set_uint (value, priv->candidate_batch_size);
+        break;
+      case PROP_CANDIDATE_BATCH_LATENCY:
+        g_value_set_uint (value, priv->candidate_batch_latency);
+        break;
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
         break;
     }
 }
 
+static gboolean
+candidates_batched (TpyCallStreamEndpoint *self)
+{
+  return self->priv->candidate_batch_size != 1 ||
+      self->priv->candidate_batch_latency > 0;
+}
+
 static void
 tpy_call_stream_endpoint_set_property (GObject *object,
     guint property_id,
@@ -164,13 +209,16 @@ tpy_call_stream_endpoint_set_property (GObject *object,
       case PROP_STREAM_STATE:
         priv->stream_state = g_value_get_uint (value);
         break;
-      case PROP_SELECTED_CANDIDATE:
-        {
-          g_boxed_free (TPY_STRUCT_TYPE_CANDIDATE,
-              priv->selected_candidate);
-          priv->selected_candidate = g_value_get_boxed (value);
-          break;
-        }
+      case PROP_CANDIDATE_BATCH_SIZE:
+        priv->candidate_batch_size = g_value_get_uint (value);
+        if (!candidates_batched (endpoint))
+          tpy_call_stream_endpoint_flush_candidates (endpoint);
+        break;
+      case PROP_CANDIDATE_BATCH_LATENCY:
+        priv->candidate_batch_latency = g_value_get_uint (value);
+        if (!candidates_batched (endpoint))
+          tpy_call_stream_endpoint_flush_candidates (endpoint);
+        break;
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
         break;
@@ -281,6 +329,24 @@ tpy_call_stream_endpoint_class_init (
       G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS);
   g_object_class_install_property (object_class, PROP_DBUS_DAEMON, param_spec);
 
+  /* With the defaults (1 and 0) every new remote candidate is signalled
+   * immediately */
+  param_spec = g_param_spec_uint ("candidate-batch-size",
+      "Candidate batch size",
+      "Number of remote candidates to signal at once, 0 for unlimited",
+      0, G_MAXUINT, 1,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (object_class, PROP_CANDIDATE_BATCH_SIZE,
+      param_spec);
+
+  param_spec = g_param_spec_uint ("candidate-batch-latency",
+      "Candidate batch latency",
+      "Maximum time in ms before queued remote candidates are signalled",
+      0, G_MAXUINT, 0,
+      G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (object_class,
+      PROP_CANDIDATE_BATCH_LATENCY, param_spec);
+
   tpy_call_stream_endpoint_class->dbus_props_class.interfaces =
       prop_interfaces;
   tp_dbus_properties_mixin_class_init (object_class,
@@ -298,6 +364,12 @@ tpy_call_stream_endpoint_dispose (GObject *object)
 
   priv->dispose_has_run = TRUE;
 
+  if (priv->candidates_flush_id != 0)
+    {
+      g_source_remove (priv->candidates_flush_id);
+      priv->candidates_flush_id = 0;
+    }
+
   tp_clear_object (&priv->dbus_daemon);
 
   if (G_OBJECT_CLASS (tpy_call_stream_endpoint_parent_class)->dispose)
@@ -314,10 +386,15 @@ tpy_call_stream_endpoint_finalize (GObject *object)
   /* free any data held directly by the object here */
   g_free (priv->object_path);
 
-  g_boxed_free (TPY_STRUCT_TYPE_CANDIDATE, priv->selected_candidate);
-  g_boxed_free (TPY_STRUCT_TYPE_STREAM_CREDENTIALS,
-      priv->remote_credentials);
-  g_boxed_free (TPY_ARRAY_TYPE_CANDIDATE_LIST, priv->remote_candidates);
+  tpy_call_stream_candidate_free (priv->selected_candidate);
+  tp_clear_pointer (&priv->remote_candidates, g_ptr_array_unref);
+
+  if (priv->pending_candidates != NULL)
+    {
+      g_ptr_array_foreach (priv->pending_candidates,
+          (GFunc) tpy_call_stream_candidate_free, NULL);
+      g_ptr_array_unref (priv->pending_candidates);
+    }
 
   G_OBJECT_CLASS (tpy_call_stream_endpoint_parent_class)->finalize (object);
 }
@@ -342,6 +419,8 @@ call_stream_endpoint_set_stream_state (TpySvcCallStreamEndpoint *iface,
   g_object_notify (G_OBJECT (self), "stream-state");
 
   tpy_svc_call_stream_endpoint_emit_stream_state_changed (self, state);
+  tpy_dbus_properties_queue_changed (G_OBJECT (self),
+      TPY_IFACE_CALL_STREAM_ENDPOINT, "StreamState");
   tpy_svc_call_stream_endpoint_return_from_set_stream_state (context);
 }
 
@@ -388,13 +467,14 @@ call_stream_endpoint_set_selected_candidate (
       goto error;
     }
 
-  g_boxed_free (TPY_STRUCT_TYPE_CANDIDATE,
-      self->priv->selected_candidate);
+  tpy_call_stream_candidate_free (self->priv->selected_candidate);
   self->priv->selected_candidate =
-      g_boxed_copy (TPY_STRUCT_TYPE_CANDIDATE, candidate);
+      tpy_call_stream_candidate_new_from_value_array (candidate);
   g_object_notify (G_OBJECT (self), "selected-candidate");
 
   tpy_svc_call_stream_endpoint_emit_candidate_selected (self, candidate);
+  tpy_dbus_properties_queue_changed (G_OBJECT (self),
+      TPY_IFACE_CALL_STREAM_ENDPOINT, "SelectedCandidate");
   tpy_svc_call_stream_endpoint_return_from_set_selected_candidate (context);
   return;
 
@@ -435,26 +515,133 @@ tpy_call_stream_endpoint_get_object_path (
   return endpoint->priv->object_path;
 }
 
+/**
+ * tpy_call_stream_endpoint_flush_candidates:
+ *
+ * Signals any remote candidates still queued by candidate-batch-size or
+ * candidate-batch-latency, for instance once the last of them is known.
+ */
+void
+tpy_call_stream_endpoint_flush_candidates (TpyCallStreamEndpoint *self)
+{
+  TpyCallStreamEndpointPrivate *priv = self->priv;
+  GPtrArray *candidates;
+  guint i;
+
+  if (priv->candidates_flush_id != 0)
+    {
+      g_source_remove (priv->candidates_flush_id);
+      priv->candidates_flush_id = 0;
+    }
+
+  if (priv->pending_candidates == NULL ||
+      priv->pending_candidates->len == 0)
+    return;
+
+  candidates = tpy_call_stream_candidate_list_to_value_arrays (
+      priv->pending_candidates);
+
+  for (i = 0; i < priv->pending_candidates->len; i++)
+    call_stream_endpoint_take_remote_candidate (self,
+        g_ptr_array_index (priv->pending_candidates, i));
+  g_ptr_array_set_size (priv->pending_candidates, 0);
+
+  DEBUG ("Signalling %u batched remote candidates", candidates->len);
+
+  tpy_svc_call_stream_endpoint_emit_remote_candidates_added (self,
+      candidates);
+  tpy_dbus_properties_queue_changed (G_OBJECT (self),
+      TPY_IFACE_CALL_STREAM_ENDPOINT, "RemoteCandidates");
+
+  g_boxed_free (TPY_ARRAY_TYPE_CANDIDATE_LIST, candidates);
+}
+
+static gboolean
+flush_candidates_timeout_cb (gpointer user_data)
+{
+  TpyCallStreamEndpoint *self = user_data;
+
+  self->priv->candidates_flush_id = 0;
+  tpy_call_stream_endpoint_flush_candidates (self);
+
+  return FALSE;
+}
+
+/* Takes ownership of @c */
+static void
+call_stream_endpoint_queue_candidate (TpyCallStreamEndpoint *self,
+    TpyCallStreamCandidate *c)
+{
+  TpyCallStreamEndpointPrivate *priv = self->priv;
+
+  if (priv->pending_candidates == NULL)
+    priv->pending_candidates = g_ptr_array_new ();
+
+  g_ptr_array_add (priv->pending_candidates, c);
+
+  if (priv->candidate_batch_size > 0 &&
+      priv->pending_candidates->len >= priv->candidate_batch_size)
+    tpy_call_stream_endpoint_flush_candidates (self);
+  else if (priv->candidate_batch_latency > 0 &&
+      priv->candidates_flush_id == 0)
+    priv->candidates_flush_id = g_timeout_add (
+        priv->candidate_batch_latency, flush_candidates_timeout_cb, self);
+}
+
 void
 tpy_call_stream_endpoint_add_new_candidates (
     TpyCallStreamEndpoint *self,
     GPtrArray *candidates)
 {
   guint i;
-  GValueArray *c;
+  TpyCallStreamCandidate *c;
+  /* the candidates to signal, if some of them had to be skipped */
+  GPtrArray *valid = NULL;
 
   if (candidates == NULL)
     return;
 
   for (i = 0; i < candidates->len; i++)
     {
-      c = g_boxed_copy (TPY_STRUCT_TYPE_CANDIDATE,
+      c = tpy_call_stream_candidate_new_from_value_array (
           g_ptr_array_index (candidates, i));
-      g_ptr_array_add (self->priv->remote_candidates, c);
+
+      if (c == NULL)
+        {
+          if (valid == NULL)
+            {
+              guint j;
+
+              valid = g_ptr_array_sized_new (candidates->len);
+
+              for (j = 0; j < i; j++)
+                g_ptr_array_add (valid, g_ptr_array_index (candidates, j));
+            }
+
+          continue;
+        }
+
+      if (valid != NULL)
+        g_ptr_array_add (valid, g_ptr_array_index (candidates, i));
+
+      if (candidates_batched (self))
+        call_stream_endpoint_queue_candidate (self, c);
+      else
+        call_stream_endpoint_take_remote_candidate (self, c);
     }
 
-  tpy_svc_call_stream_endpoint_emit_remote_candidates_added (self,
-      candidates);
+  if (!candidates_batched (self) &&
+      (valid == NULL ? candidates->len : valid->len) > 0)
+    {
+      tpy_svc_call_stream_endpoint_emit_remote_candidates_added (self,
+          valid != NULL ? valid : candidates);
+      tpy_dbus_properties_queue_changed (G_OBJECT (self),
+          TPY_IFACE_CALL_STREAM_ENDPOINT, "RemoteCandidates");
+    }
+
+  /* the candidates themselves are still the caller's */
+  if (valid != NULL)
+    g_ptr_array_free (valid, TRUE);
 }
 
 void tpy_call_stream_endpoint_add_new_candidate (
@@ -464,19 +651,211 @@ void tpy_call_stream_endpoint_add_new_candidate (
     guint port,
     const GHashTable *info_hash)
 {
-  GPtrArray *candidates = g_ptr_array_sized_new (1);
-  GValueArray *a;
+  GPtrArray *candidates;
+  TpyCallStreamCandidate *c;
+
+  c = tpy_call_stream_candidate_new (component, address, port,
+      (GHashTable *) info_hash);
+
+  if (c == NULL)
+    return;
+
+  /* When batching, no D-Bus representation is needed until the flush */
+  if (candidates_batched (self))
+    {
+      call_stream_endpoint_queue_candidate (self, c);
+      return;
+    }
 
-  a = tp_value_array_build (4,
-      G_TYPE_UINT, component,
-      G_TYPE_STRING, address,
-      G_TYPE_UINT, port,
-      TPY_HASH_TYPE_CANDIDATE_INFO, info_hash,
-      G_TYPE_INVALID);
+  call_stream_endpoint_take_remote_candidate (self, c);
 
-  g_ptr_array_add (candidates, a);
+  candidates = g_ptr_array_sized_new (1);
+  g_ptr_array_add (candidates, tpy_call_stream_candidate_to_value_array (c));
 
-  tpy_call_stream_endpoint_add_new_candidates (self, candidates);
+  tpy_svc_call_stream_endpoint_emit_remote_candidates_added (self,
+      candidates);
+  tpy_dbus_properties_queue_changed (G_OBJECT (self),
+      TPY_IFACE_CALL_STREAM_ENDPOINT, "RemoteCandidates");
 
   g_boxed_free (TPY_ARRAY_TYPE_CANDIDATE_LIST, candidates);
 }
+
+/* Candidate addresses are shared between candidates, refcounted so that
+ * addresses of finished calls don't accumulate for the life of the CM. */
+static GHashTable *candidate_addresses = NULL;
+
+static const gchar *
+candidate_address_ref (const gchar *address)
+{
+  gpointer key, count;
+
+  if (address == NULL)
+    address = "";
+
+  if (candidate_addresses == NULL)
+    candidate_addresses = g_hash_table_new (g_str_hash, g_str_equal);
+
+  if (g_hash_table_lookup_extended (candidate_addresses, address, &key,
+          &count))
+    {
+      g_hash_table_insert (candidate_addresses, key,
+          GUINT_TO_POINTER (GPOINTER_TO_UINT (count) + 1));
+      return key;
+    }
+
+  key = g_strdup (address);
+  g_hash_table_insert (candidate_addresses, key, GUINT_TO_POINTER (1));
+
+  return key;
+}
+
+static void
+candidate_address_unref (const gchar *address)
+{
+  guint count;
+
+  g_return_if_fail (candidate_addresses != NULL);
+
+  count = GPOINTER_TO_UINT (g_hash_table_lookup (candidate_addresses,
+          address));
+  g_return_if_fail (count > 0);
+
+  if (count > 1)
+    {
+      g_hash_table_insert (candidate_addresses, (gchar *) address,
+          GUINT_TO_POINTER (count - 1));
+      return;
+    }
+
+  g_hash_table_remove (candidate_addresses, address);
+  g_free ((gchar *) address);
+}
+
+/**
+ * tpy_call_stream_candidate_new:
+ *
+ * The info hash is copied, so the caller keeps ownership of it.
+ *
+ * Returns: a new candidate, to be freed with tpy_call_stream_candidate_free,
+ *  or %NULL if the component or port is out of range
+ */
+TpyCallStreamCandidate *
+tpy_call_stream_candidate_new (TpyStreamComponent component,
+    const gchar *address,
+    guint port,
+    GHashTable *info)
+{
+  TpyCallStreamCandidate *self;
+
+  /* These come from the network or from D-Bus, so are not trusted */
+  if (component > G_MAXUINT16 || port > G_MAXUINT16)
+    {
+      DEBUG ("Ignoring candidate %s:%u with component %u: out of range",
+          address, port, component);
+      return NULL;
+    }
+
+  self = g_slice_new (TpyCallStreamCandidate);
+  self->component = component;
+  self->port = port;
+  self->address = candidate_address_ref (address);
+
+  if (info != NULL && g_hash_table_size (info) > 0)
+    self->info = g_boxed_copy (TPY_HASH_TYPE_CANDIDATE_INFO, info);
+  else
+    self->info = NULL;
+
+  return self;
+}
+
+TpyCallStreamCandidate *
+tpy_call_stream_candidate_new_from_value_array (const GValueArray *candidate)
+{
+  g_return_val_if_fail (candidate != NULL, NULL);
+  g_return_val_if_fail (candidate->n_values == 4, NULL);
+
+  return tpy_call_stream_candidate_new (
+      g_value_get_uint (candidate->values + 0),
+      g_value_get_string (candidate->values + 1),
+      g_value_get_uint (candidate->values + 2),
+      g_value_get_boxed (candidate->values + 3));
+}
+
+void
+tpy_call_stream_candidate_free (TpyCallStreamCandidate *self)
+{
+  if (self == NULL)
+    return;
+
+  candidate_address_unref (self->address);
+  tp_clear_pointer (&self->info, g_hash_table_unref);
+
+  g_slice_free (TpyCallStreamCandidate, self);
+}
+
+static GHashTable *
+empty_candidate_info (void)
+{
+  static gsize empty = 0;
+
+  if (g_once_init_enter (&empty))
+    g_once_init_leave (&empty,
+        (gsize) g_hash_table_new (g_str_hash, g_str_equal));
+
+  return (GHashTable *) empty;
+}
+
+GValueArray *
+tpy_call_stream_candidate_to_value_array (const TpyCallStreamCandidate *self)
+{
+  GValueArray *va;
+  GValue *v;
+  GHashTable *info;
+
+  info = self->info != NULL ? self->info : empty_candidate_info ();
+
+  va = g_value_array_new (4);
+
+  g_value_array_append (va, NULL);
+  v = g_value_array_get_nth (va, 0);
+  g_value_init (v, G_TYPE_UINT);
+  g_value_set_uint (v, self->component);
+
+  g_value_array_append (va, NULL);
+  v = g_value_array_get_nth (va, 1);
+  g_value_init (v, G_TYPE_STRING);
+  g_value_set_string (v, self->address);
+
+  g_value_array_append (va, NULL);
+  v = g_value_array_get_nth (va, 2);
+  g_value_init (v, G_TYPE_UINT);
+  g_value_set_uint (v, self->port);
+
+  /* The info hash is never modified once stored, so share it rather than
+   * letting the boxed type deep-copy it */
+  g_value_array_append (va, NULL);
+  v = g_value_array_get_nth (va, 3);
+  g_value_init (v, TPY_HASH_TYPE_CANDIDATE_INFO);
+  g_value_take_boxed (v, g_hash_table_ref (info));
+
+  return va;
+}
+
+/**
+ * tpy_call_stream_candidate_list_to_value_arrays:
+ * @candidates: a #GPtrArray of #TpyCallStreamCandidate
+ *
+ * Returns: a new TPY_ARRAY_TYPE_CANDIDATE_LIST, for use on D-Bus
+ */
+GPtrArray *
+tpy_call_stream_candidate_list_to_value_arrays (const GPtrArray *candidates)
+{
+  GPtrArray *arr = g_ptr_array_sized_new (candidates->len);
+  guint i;
+
+  for (i = 0; i < candidates->len; i++)
+    g_ptr_array_add (arr, tpy_call_stream_candidate_to_value_array (
+            g_ptr_array_index (candidates, i)));
+
+  return arr;
+}
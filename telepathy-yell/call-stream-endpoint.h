@@ -34,6 +34,18 @@ typedef struct _TpyCallStreamEndpoint TpyCallStreamEndpoint;
 typedef struct _TpyCallStreamEndpointPrivate
   TpyCallStreamEndpointPrivate;
 typedef struct _TpyCallStreamEndpointClass TpyCallStreamEndpointClass;
+typedef struct _TpyCallStreamCandidate TpyCallStreamCandidate;
+
+/* Native form of a Call candidate (TPY_STRUCT_TYPE_CANDIDATE). The address
+ * is shared between all candidates with the same address. The info hash is
+ * copied once when the candidate is created, is never modified afterwards,
+ * and is NULL when empty. */
+struct _TpyCallStreamCandidate {
+    guint16 component;
+    guint16 port;
+    const gchar *address;
+    GHashTable *info;
+};
 
 struct _TpyCallStreamEndpointClass {
     GObjectClass parent_class;
@@ -80,10 +92,25 @@ void tpy_call_stream_endpoint_add_new_candidate (
     const gchar *address,
     guint port,
     const GHashTable *info_hash);
+void tpy_call_stream_endpoint_flush_candidates (
+    TpyCallStreamEndpoint *endpoint);
 
 const gchar *tpy_call_stream_endpoint_get_object_path (
     TpyCallStreamEndpoint *endpoint);
 
+TpyCallStreamCandidate *tpy_call_stream_candidate_new (
+    TpyStreamComponent component,
+    const gchar *address,
+    guint port,
+    GHashTable *info);
+TpyCallStreamCandidate *tpy_call_stream_candidate_new_from_value_array (
+    const GValueArray *candidate);
+void tpy_call_stream_candidate_free (TpyCallStreamCandidate *self);
+GValueArray *tpy_call_stream_candidate_to_value_array (
+    const TpyCallStreamCandidate *self);
+GPtrArray *tpy_call_stream_candidate_list_to_value_arrays (
+    const GPtrArray *candidates);
+
 G_END_DECLS
 
 #endif /* #ifndef __TPY_CALL_STREAM_ENDPOINT_H__*/
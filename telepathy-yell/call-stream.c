@@ -45,8 +45,6 @@ struct _TpyCallStreamPrivate
   TpySendingState local_sending_state;
   gboolean can_request_receiving;
   gboolean ready;
-
-  GSimpleAsyncResult *result;
 };
 
 static void
@@ -58,6 +56,7 @@ on_call_stream_get_all_properties_cb (TpProxy *proxy,
 {
   TpyCallStream *self = TPY_CALL_STREAM (proxy);
   GHashTable *members;
+  TpySendingState local_sending_state;
 
   if (error != NULL)
     {
@@ -65,8 +64,14 @@ on_call_stream_get_all_properties_cb (TpProxy *proxy,
       return;
     }
 
-  self->priv->local_sending_state = tp_asv_get_uint32 (properties,
+  local_sending_state = tp_asv_get_uint32 (properties,
       "LocalSendingState", NULL);
+  if (self->priv->local_sending_state != local_sending_state)
+    {
+      self->priv->local_sending_state = local_sending_state;
+      g_object_notify (G_OBJECT (self), "local-sending-state");
+    }
+
   self->priv->can_request_receiving = tp_asv_get_boolean (properties,
       "CanRequestReceiving", NULL);
 
@@ -171,7 +176,6 @@ tpy_call_stream_dispose (GObject *object)
 {
   TpyCallStream *self = TPY_CALL_STREAM (object);
 
-  tp_clear_object (&self->priv->result);
   tp_clear_pointer (&self->priv->remote_members, g_hash_table_unref);
 
   G_OBJECT_CLASS (tpy_call_stream_parent_class)->dispose (object);
@@ -288,18 +292,20 @@ on_set_sending_cb (TpProxy *proxy,
     gpointer user_data,
     GObject *weak_object)
 {
-  TpyCallStream *self = TPY_CALL_STREAM (proxy);
+  GSimpleAsyncResult *result = user_data;
 
   if (error != NULL)
     {
       DEBUG ("Failed to set sending: %s", error->message);
 
-      g_simple_async_result_set_from_error (self->priv->result, error);
+      g_simple_async_result_set_from_error (result, error);
+    }
+  else
+    {
+      g_simple_async_result_set_op_res_gboolean (result, TRUE);
     }
 
-  g_simple_async_result_set_op_res_gboolean (self->priv->result, TRUE);
-  g_simple_async_result_complete (self->priv->result);
-  tp_clear_object (&self->priv->result);
+  g_simple_async_result_complete (result);
 }
 
 void
@@ -308,15 +314,16 @@ tpy_call_stream_set_sending_async (TpyCallStream *self,
     GAsyncReadyCallback callback,
     gpointer user_data)
 {
+  GSimpleAsyncResult *result;
+
   g_return_if_fail (TPY_IS_CALL_STREAM (self));
-  g_return_if_fail (self->priv->result == NULL);
 
-  self->priv->result = g_simple_async_result_new (G_OBJECT (self), callback,
+  result = g_simple_async_result_new (G_OBJECT (self), callback,
       user_data, tpy_call_stream_set_sending_async);
 
   tpy_cli_call_stream_call_set_sending (TP_PROXY (self), -1,
       send,
-      on_set_sending_cb, NULL, NULL, G_OBJECT (self));
+      on_set_sending_cb, result, g_object_unref, NULL);
 }
 
 gboolean
@@ -342,18 +349,20 @@ on_request_receiving_cb (TpProxy *proxy,
     gpointer user_data,
     GObject *weak_object)
 {
-  TpyCallStream *self = TPY_CALL_STREAM (proxy);
+  GSimpleAsyncResult *result = user_data;
 
   if (error != NULL)
     {
       DEBUG ("Failed to request receiving: %s", error->message);
 
-      g_simple_async_result_set_from_error (self->priv->result, error);
+      g_simple_async_result_set_from_error (result, error);
+    }
+  else
+    {
+      g_simple_async_result_set_op_res_gboolean (result, TRUE);
     }
 
-  g_simple_async_result_set_op_res_gboolean (self->priv->result, TRUE);
-  g_simple_async_result_complete (self->priv->result);
-  tp_clear_object (&self->priv->result);
+  g_simple_async_result_complete (result);
 }
 
 void
@@ -363,15 +372,16 @@ tpy_call_stream_request_receiving_async (TpyCallStream *self,
     GAsyncReadyCallback callback,
     gpointer user_data)
 {
+  GSimpleAsyncResult *result;
+
   g_return_if_fail (TPY_IS_CALL_STREAM (self));
-  g_return_if_fail (self->priv->result == NULL);
 
-  self->priv->result = g_simple_async_result_new (G_OBJECT (self), callback,
+  result = g_simple_async_result_new (G_OBJECT (self), callback,
       user_data, tpy_call_stream_request_receiving_async);
 
   tpy_cli_call_stream_call_request_receiving (TP_PROXY (self), -1,
       handle, receiving,
-      on_request_receiving_cb, NULL, NULL, G_OBJECT (self));
+      on_request_receiving_cb, result, g_object_unref, NULL);
 }
 
 gboolean
@@ -26,6 +26,14 @@
 
 static TpyDebugFlags flags = 0;
 
+/* Held for the lifetime of the process once something has been logged, so
+ * that we can cheaply check whether anyone is listening on the bus. */
+static TpDebugSender *debug_sender = NULL;
+static gboolean debug_sender_enabled = FALSE;
+/* Whether to record messages in the debug sender's backlog while nobody is
+ * listening */
+static gboolean capture_backlog = FALSE;
+
 static GDebugKey debug_keys[] = {
   {"call", TPY_DEBUG_CALL},
   {NULL, 0}
@@ -41,6 +49,62 @@ tpy_debug_set_flags (const char *flags_string)
   flags |= g_parse_debug_string (flags_string, debug_keys, nkeys);
 }
 
+/**
+ * tpy_debug_set_capture_backlog:
+ * @capture: whether to record messages while no debug client is listening
+ *
+ * By default, messages only go to the #TpDebugSender while a debug client
+ * has it enabled, so that nothing is formatted when nobody is looking. If
+ * @capture is %TRUE, every message is recorded in its backlog instead, for
+ * a debugger attaching mid-call to see, at the cost of always formatting
+ * them.
+ */
+void
+tpy_debug_set_capture_backlog (gboolean capture)
+{
+  capture_backlog = capture;
+}
+
+static void
+debug_sender_notify_enabled_cb (TpDebugSender *sender,
+    GParamSpec *pspec,
+    gpointer user_data)
+{
+  g_object_get (sender, "enabled", &debug_sender_enabled, NULL);
+}
+
+static void
+ensure_debug_sender (void)
+{
+  if (G_LIKELY (debug_sender != NULL))
+    return;
+
+  debug_sender = tp_debug_sender_dup ();
+  g_object_get (debug_sender, "enabled", &debug_sender_enabled, NULL);
+  g_signal_connect (debug_sender, "notify::enabled",
+      G_CALLBACK (debug_sender_notify_enabled_cb), NULL);
+}
+
+/**
+ * tpy_debug_flag_is_set:
+ * @flag: the category a message would be logged in
+ *
+ * Returns: %TRUE if a message in @flag would be printed, if a debug client
+ *  is currently subscribed to the #TpDebugSender, or if the backlog is being
+ *  captured. The DEBUG() family of macros use this to skip formatting
+ *  messages nobody would see.
+ */
+gboolean
+tpy_debug_flag_is_set (TpyDebugFlags flag)
+{
+  if ((flag & flags) || capture_backlog)
+    return TRUE;
+
+  ensure_debug_sender ();
+
+  return debug_sender_enabled;
+}
+
 static const char *
 debug_flag_to_domain (TpyDebugFlags flag)
 {
@@ -71,10 +135,8 @@ void tpy_log (GLogLevelFlags level,
                 const gchar *format,
                 ...)
 {
-  TpDebugSender *debug_sender = tp_debug_sender_dup ();
   char *message;
   va_list args;
-  GTimeVal now;
 
   va_start (args, format);
   message = g_strdup_vprintf (format, args);
@@ -83,11 +145,17 @@ void tpy_log (GLogLevelFlags level,
   if (flag & flags)
     g_log (G_LOG_DOMAIN, level, "%s", message);
 
-  g_get_current_time (&now);
+  ensure_debug_sender ();
+
+  if (debug_sender_enabled || capture_backlog)
+    {
+      GTimeVal now;
+
+      g_get_current_time (&now);
 
-  tp_debug_sender_add_message (debug_sender, &now, debug_flag_to_domain (flag),
-      level, message);
+      tp_debug_sender_add_message (debug_sender, &now,
+          debug_flag_to_domain (flag), level, message);
+    }
 
   g_free (message);
-  g_object_unref (debug_sender);
 }
@@ -32,30 +32,36 @@ typedef enum
 } TpyDebugFlags;
 
 void tpy_debug_set_flags (const char *flags_string);
+void tpy_debug_set_capture_backlog (gboolean capture);
+
+gboolean tpy_debug_flag_is_set (TpyDebugFlags flag);
 
 void tpy_log (GLogLevelFlags level, TpyDebugFlags flag,
                 const gchar *format, ...) G_GNUC_PRINTF(3, 4);
 
 #ifdef DEBUG_FLAG
 
+/* The arguments are only evaluated and formatted if someone is going to see
+ * the message, either on stderr or through the debug sender. */
+#define TPY_LOG_IF_ENABLED(level, format, ...) \
+  G_STMT_START { \
+    if (tpy_debug_flag_is_set (DEBUG_FLAG)) \
+      tpy_log (level, DEBUG_FLAG, "%s: " format, \
+          G_STRFUNC, ##__VA_ARGS__); \
+  } G_STMT_END
+
 #define ERROR(format, ...) \
-  tpy_log (G_LOG_LEVEL_ERROR, DEBUG_FLAG, "%s: " format, \
-             G_STRFUNC, ##__VA_ARGS__)
+  TPY_LOG_IF_ENABLED (G_LOG_LEVEL_ERROR, format, ##__VA_ARGS__)
 #define CRITICAL(format, ...) \
-  tpy_log (G_LOG_LEVEL_CRITICAL, DEBUG_FLAG, "%s: " format, \
-             G_STRFUNC, ##__VA_ARGS__)
+  TPY_LOG_IF_ENABLED (G_LOG_LEVEL_CRITICAL, format, ##__VA_ARGS__)
 #define WARNING(format, ...) \
-  tpy_log (G_LOG_LEVEL_WARNING, DEBUG_FLAG, "%s: " format, \
-             G_STRFUNC, ##__VA_ARGS__)
+  TPY_LOG_IF_ENABLED (G_LOG_LEVEL_WARNING, format, ##__VA_ARGS__)
 #define MESSAGE(format, ...) \
-  tpy_log (G_LOG_LEVEL_MESSAGE, DEBUG_FLAG, "%s: " format, \
-             G_STRFUNC, ##__VA_ARGS__)
+  TPY_LOG_IF_ENABLED (G_LOG_LEVEL_MESSAGE, format, ##__VA_ARGS__)
 #define INFO(format, ...) \
-  tpy_log (G_LOG_LEVEL_INFO, DEBUG_FLAG, "%s: " format, \
-             G_STRFUNC, ##__VA_ARGS__)
+  TPY_LOG_IF_ENABLED (G_LOG_LEVEL_INFO, format, ##__VA_ARGS__)
 #define DEBUG(format, ...) \
-  tpy_log (G_LOG_LEVEL_DEBUG, DEBUG_FLAG, "%s: " format, \
-             G_STRFUNC, ##__VA_ARGS__)
+  TPY_LOG_IF_ENABLED (G_LOG_LEVEL_DEBUG, format, ##__VA_ARGS__)
 
 #endif /* DEBUG_FLAG */
 
@@ -1,6 +1,118 @@
 #include "extensions.h"
 
+#include <telepathy-glib/dbus-properties-mixin.h>
+
 /* include auto-generated stubs for things common to service and client */
 #include "_gen/gtypes-body.h"
 #include "_gen/interfaces-body.h"
 #include "_gen/signals-marshal.h"
+
+/* Properties changed since PropertiesChanged was last emitted:
+ * GObject => (interface name => GPtrArray of property names). The names are
+ * interned strings. */
+static GHashTable *changed_properties = NULL;
+static guint changed_properties_idle_id = 0;
+
+static void
+changed_object_finalized_cb (gpointer data,
+    GObject *where_the_object_was)
+{
+  g_hash_table_remove (changed_properties, where_the_object_was);
+}
+
+static gboolean
+flush_changed_properties_idle (gpointer data)
+{
+  GHashTable *objects = changed_properties;
+  GHashTableIter iter;
+  gpointer object, interfaces;
+
+  /* anything changed while emitting is signalled next time */
+  changed_properties = NULL;
+  changed_properties_idle_id = 0;
+
+  g_hash_table_iter_init (&iter, objects);
+  while (g_hash_table_iter_next (&iter, &object, NULL))
+    {
+      g_object_weak_unref (object, changed_object_finalized_cb, NULL);
+      g_object_ref (object);
+    }
+
+  g_hash_table_iter_init (&iter, objects);
+  while (g_hash_table_iter_next (&iter, &object, &interfaces))
+    {
+      GHashTableIter ifaces_iter;
+      gpointer iface, names;
+
+      g_hash_table_iter_init (&ifaces_iter, interfaces);
+      while (g_hash_table_iter_next (&ifaces_iter, &iface, &names))
+        {
+          g_ptr_array_add (names, NULL);
+          tp_dbus_properties_mixin_emit_properties_changed (object, iface,
+              (const gchar * const *) ((GPtrArray *) names)->pdata);
+        }
+
+      g_object_unref (object);
+    }
+
+  g_hash_table_unref (objects);
+
+  return FALSE;
+}
+
+/**
+ * tpy_dbus_properties_queue_changed:
+ * @object: an object using the #TpDBusPropertiesMixin
+ * @interface_name: the interface @property_name belongs to
+ * @property_name: a property declared to emit PropertiesChanged
+ *
+ * Marks @property_name as changed. Once the main loop is idle, each object
+ * with changed properties emits one PropertiesChanged per interface. It
+ * carries the new values of properties annotated with EmitsChangedSignal
+ * "true", and only the names of those annotated "invalidates".
+ */
+void
+tpy_dbus_properties_queue_changed (GObject *object,
+    const gchar *interface_name,
+    const gchar *property_name)
+{
+  GHashTable *interfaces;
+  GPtrArray *names;
+  const gchar *name = g_intern_string (property_name);
+  guint i;
+
+  g_return_if_fail (G_IS_OBJECT (object));
+
+  if (changed_properties == NULL)
+    changed_properties = g_hash_table_new_full (NULL, NULL, NULL,
+        (GDestroyNotify) g_hash_table_unref);
+
+  interfaces = g_hash_table_lookup (changed_properties, object);
+
+  if (interfaces == NULL)
+    {
+      interfaces = g_hash_table_new_full (NULL, NULL, NULL,
+          (GDestroyNotify) g_ptr_array_unref);
+      g_hash_table_insert (changed_properties, object, interfaces);
+      g_object_weak_ref (object, changed_object_finalized_cb, NULL);
+    }
+
+  interface_name = g_intern_string (interface_name);
+  names = g_hash_table_lookup (interfaces, interface_name);
+
+  if (names == NULL)
+    {
+      names = g_ptr_array_new ();
+      g_hash_table_insert (interfaces, (gpointer) interface_name, names);
+    }
+
+  for (i = 0; i < names->len; i++)
+    if (g_ptr_array_index (names, i) == name)
+      return;
+
+  g_ptr_array_add (names, (gpointer) name);
+
+  if (changed_properties_idle_id == 0)
+    changed_properties_idle_id = g_idle_add (flush_changed_properties_idle,
+        NULL);
+}
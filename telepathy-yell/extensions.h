@@ -16,6 +16,10 @@ G_BEGIN_DECLS
 
 void tpy_cli_init (void);
 
+void tpy_dbus_properties_queue_changed (GObject *object,
+    const gchar *interface_name,
+    const gchar *property_name);
+
 G_END_DECLS
 
 #endif
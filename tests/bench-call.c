@@ -0,0 +1,624 @@
+/*
+ * bench-call.c - microbenchmarks for the call base classes
+ * Copyright © 2011 Collabora Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/* Runs the base classes through their hot paths against a TestConnection
+ * on the session bus, which should be a private one (see "make bench").
+ * D-Bus methods are called by this same process, as a streaming
+ * implementation or UI would.
+ *
+ * Each benchmark prints one line of JSON:
+ *   {"benchmark": NAME, "ops": N, "seconds": S, "ops_per_sec": R,
+ *    "allocs_per_op": A, "peak_rss_kb": K}
+ * allocs_per_op counts GLib allocations (libdbus uses malloc directly),
+ * including those made by the calling side; it is null if GLib can't count
+ * them. peak_rss_kb is for the whole process so far.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include <glib-object.h>
+
+#include <telepathy-glib/connection.h>
+#include <telepathy-glib/dbus.h>
+#include <telepathy-glib/interfaces.h>
+#include <telepathy-glib/proxy-subclass.h>
+#include <telepathy-glib/util.h>
+
+#include <telepathy-yell/call-channel.h>
+#include <telepathy-yell/extensions.h>
+
+#include "test-call.h"
+#include "test-connection.h"
+
+/* Calls kept in flight by benchmarks which can pipeline them */
+#define WINDOW 32
+/* Members of the call besides the ones being churned */
+#define N_STEADY_MEMBERS 8
+#define N_CANDIDATES 4
+#define N_CODECS 6
+
+static guint64 n_allocs = 0;
+
+static gpointer
+counting_malloc (gsize n_bytes)
+{
+  n_allocs++;
+  return malloc (n_bytes);
+}
+
+static gpointer
+counting_realloc (gpointer mem,
+    gsize n_bytes)
+{
+  if (mem == NULL)
+    n_allocs++;
+
+  return realloc (mem, n_bytes);
+}
+
+static gpointer
+counting_calloc (gsize n_blocks,
+    gsize n_block_bytes)
+{
+  n_allocs++;
+  return calloc (n_blocks, n_block_bytes);
+}
+
+static GMemVTable counting_vtable = {
+    counting_malloc,
+    counting_realloc,
+    free,
+    counting_calloc,
+    NULL,
+    NULL
+};
+
+typedef struct {
+    TpDBusDaemon *dbus;
+    TestConnection *conn;
+    TpConnection *conn_proxy;
+    TpHandle peer;
+    TpHandle contacts[WINDOW];
+
+    TestCallChannel *chan;
+    TpyBaseMediaCallContent *content;
+
+    /* D-Bus calls made and answered */
+    guint calls;
+    guint replies;
+} Bench;
+
+typedef void (*BenchSetupFunc) (Bench *bench);
+typedef void (*BenchFunc) (Bench *bench, guint n_ops);
+
+static gboolean allocs_counted = FALSE;
+
+static void
+drain (void)
+{
+  while (g_main_context_iteration (NULL, FALSE))
+    ;
+}
+
+static void
+wait_for_replies (Bench *bench,
+    guint outstanding)
+{
+  while (bench->calls - bench->replies > outstanding)
+    g_main_context_iteration (NULL, TRUE);
+}
+
+static void
+reply_cb (TpProxy *proxy,
+    const GError *error,
+    gpointer user_data,
+    GObject *weak_object)
+{
+  Bench *bench = user_data;
+
+  if (error != NULL)
+    g_error ("Call failed: %s", error->message);
+
+  bench->replies++;
+}
+
+static void
+channel_reply_cb (TpChannel *proxy,
+    const GError *error,
+    gpointer user_data,
+    GObject *weak_object)
+{
+  reply_cb ((TpProxy *) proxy, error, user_data, weak_object);
+}
+
+static TpProxy *
+bench_proxy_new (Bench *bench,
+    const gchar *object_path,
+    GQuark iface)
+{
+  TpProxy *proxy = g_object_new (TP_TYPE_PROXY,
+      "dbus-daemon", bench->dbus,
+      "bus-name", tp_dbus_daemon_get_unique_name (bench->dbus),
+      "object-path", object_path,
+      NULL);
+
+  tp_proxy_add_interface_by_id (proxy, iface);
+
+  return proxy;
+}
+
+static void
+bench_start_call (Bench *bench)
+{
+  bench->chan = test_call_channel_new (bench->conn, bench->peer, FALSE);
+  test_connection_announce_channel (bench->conn,
+      TP_EXPORTABLE_CHANNEL (bench->chan));
+  /* The connection keeps the channel until it is closed */
+  g_object_unref (bench->chan);
+
+  bench->content = tpy_base_call_channel_get_contents (
+      TPY_BASE_CALL_CHANNEL (bench->chan))->data;
+
+  drain ();
+}
+
+static void
+bench_end_call (Bench *bench)
+{
+  TP_BASE_CHANNEL_GET_CLASS (bench->chan)->close (
+      TP_BASE_CHANNEL (bench->chan));
+  bench->chan = NULL;
+  bench->content = NULL;
+
+  drain ();
+}
+
+/* Adding a video content, with its stream and endpoint, and removing it */
+static void
+bench_content_add_remove (Bench *bench,
+    guint n_ops)
+{
+  TpyBaseCallChannel *chan = TPY_BASE_CALL_CHANNEL (bench->chan);
+  guint i;
+
+  for (i = 0; i < n_ops; i++)
+    {
+      TpyBaseMediaCallContent *content = test_call_channel_add_content (
+          bench->chan, "video", TP_MEDIA_STREAM_TYPE_VIDEO);
+
+      tpy_base_call_channel_remove_content (chan,
+          TPY_BASE_CALL_CONTENT (content));
+
+      if (i % WINDOW == 0)
+        drain ();
+    }
+}
+
+static void
+add_steady_members (Bench *bench)
+{
+  guint i;
+
+  for (i = 0; i < N_STEADY_MEMBERS; i++)
+    {
+      gchar *id = g_strdup_printf ("member%u@example.com", i);
+
+      tpy_base_call_channel_add_member (TPY_BASE_CALL_CHANNEL (bench->chan),
+          test_connection_ensure_contact (bench->conn, id),
+          TPY_CALL_MEMBER_FLAG_RINGING);
+      g_free (id);
+    }
+
+  drain ();
+}
+
+static void
+add_steady_members_coalesced (Bench *bench)
+{
+  add_steady_members (bench);
+  tpy_base_call_channel_set_coalesce_member_changes (
+      TPY_BASE_CALL_CHANNEL (bench->chan), TRUE);
+}
+
+/* A member joining, answering and leaving */
+static void
+bench_member_churn (Bench *bench,
+    guint n_ops)
+{
+  TpyBaseCallChannel *chan = TPY_BASE_CALL_CHANNEL (bench->chan);
+  guint i;
+
+  for (i = 0; i < n_ops; i++)
+    {
+      TpHandle contact = bench->contacts[i % WINDOW];
+
+      tpy_base_call_channel_add_member (chan, contact,
+          TPY_CALL_MEMBER_FLAG_RINGING);
+      tpy_base_call_channel_update_member_flags (chan, contact, 0);
+      tpy_base_call_channel_remove_member (chan, contact);
+
+      if (i % WINDOW == 0)
+        drain ();
+    }
+
+  drain ();
+}
+
+/* AddCandidates on the stream's Media interface, as streaming
+ * implementations gather local candidates */
+static void
+bench_add_candidates (Bench *bench,
+    guint n_ops)
+{
+  TestCallStream *stream = test_call_content_get_stream (bench->content);
+  TpProxy *proxy;
+  guint i;
+
+  proxy = bench_proxy_new (bench, tpy_base_call_stream_get_object_path (
+      TPY_BASE_CALL_STREAM (stream)),
+      TPY_IFACE_QUARK_CALL_STREAM_INTERFACE_MEDIA);
+
+  for (i = 0; i < n_ops; i++)
+    {
+      GPtrArray *candidates = test_call_candidate_list_new (N_CANDIDATES,
+          i * N_CANDIDATES);
+
+      wait_for_replies (bench, WINDOW - 1);
+
+      bench->calls++;
+      tpy_cli_call_stream_interface_media_call_add_candidates (proxy, -1,
+          candidates, reply_cb, bench, NULL, NULL);
+
+      g_boxed_free (TPY_ARRAY_TYPE_CANDIDATE_LIST, candidates);
+    }
+
+  wait_for_replies (bench, 0);
+  g_object_unref (proxy);
+}
+
+/* Remote candidates arriving from the network */
+static void
+bench_endpoint_candidates (Bench *bench,
+    guint n_ops)
+{
+  TpyCallStreamEndpoint *endpoint = test_call_stream_get_endpoint (
+      test_call_content_get_stream (bench->content));
+  guint i;
+
+  for (i = 0; i < n_ops; i++)
+    {
+      GPtrArray *candidates = test_call_candidate_list_new (N_CANDIDATES,
+          i * N_CANDIDATES);
+
+      tpy_call_stream_endpoint_add_new_candidates (endpoint, candidates);
+      g_boxed_free (TPY_ARRAY_TYPE_CANDIDATE_LIST, candidates);
+
+      if (i % WINDOW == 0)
+        drain ();
+    }
+
+  drain ();
+}
+
+static void
+accept_reply_cb (TpProxy *proxy,
+    const GError *error,
+    gpointer user_data,
+    GObject *weak_object)
+{
+  reply_cb (proxy, error, user_data, weak_object);
+  g_object_unref (proxy);
+}
+
+static void
+new_codec_offer_cb (TpyBaseMediaCallContent *content,
+    guint contact,
+    const gchar *offer_path,
+    const GPtrArray *codecs,
+    gpointer user_data)
+{
+  Bench *bench = user_data;
+  TpProxy *proxy;
+  GPtrArray *local_codecs;
+
+  proxy = bench_proxy_new (bench, offer_path,
+      TPY_IFACE_QUARK_CALL_CONTENT_CODEC_OFFER);
+  local_codecs = test_call_codec_list_new (N_CODECS, 0);
+
+  /* The proxy is released when the offer has been answered */
+  bench->calls++;
+  tpy_cli_call_content_codec_offer_call_accept (proxy, -1, local_codecs,
+      accept_reply_cb, bench, NULL, NULL);
+
+  g_boxed_free (TPY_ARRAY_TYPE_CODEC_LIST, local_codecs);
+}
+
+static void
+answer_codec_offers (Bench *bench)
+{
+  g_signal_connect (bench->content, "new-codec-offer",
+      G_CALLBACK (new_codec_offer_cb), bench);
+}
+
+static void
+answer_codec_offers_cached (Bench *bench)
+{
+  GPtrArray *codecs = test_call_codec_list_new (N_CODECS, 0);
+  guint i;
+
+  answer_codec_offers (bench);
+  g_object_set (bench->content, "negotiation-cache", TRUE, NULL);
+
+  /* Answers are cached against the local codecs they were negotiated with,
+   * which the first answer sets */
+  for (i = 0; i < 2; i++)
+    {
+      tpy_base_media_call_content_offer_codecs (bench->content, bench->peer,
+          codecs);
+      wait_for_replies (bench, 0);
+    }
+
+  drain ();
+
+  g_boxed_free (TPY_ARRAY_TYPE_CODEC_LIST, codecs);
+}
+
+static void
+offer_codecs (Bench *bench,
+    guint n_ops,
+    guint n_variants)
+{
+  GPtrArray *codecs[2];
+  guint i;
+
+  codecs[0] = test_call_codec_list_new (N_CODECS, 0);
+  codecs[1] = test_call_codec_list_new (N_CODECS, 1);
+
+  for (i = 0; i < n_ops; i++)
+    {
+      tpy_base_media_call_content_offer_codecs (bench->content, bench->peer,
+          codecs[i % n_variants]);
+      wait_for_replies (bench, 0);
+    }
+
+  drain ();
+
+  g_boxed_free (TPY_ARRAY_TYPE_CODEC_LIST, codecs[0]);
+  g_boxed_free (TPY_ARRAY_TYPE_CODEC_LIST, codecs[1]);
+}
+
+/* Remote codecs changing, each offer answered by the streaming
+ * implementation over D-Bus */
+static void
+bench_codec_offer (Bench *bench,
+    guint n_ops)
+{
+  offer_codecs (bench, n_ops, 2);
+}
+
+/* The same codecs offered again, answered from the negotiation cache */
+static void
+bench_codec_offer_cached (Bench *bench,
+    guint n_ops)
+{
+  offer_codecs (bench, n_ops, 1);
+}
+
+/* MultipleTones interrupted by StopTone */
+static void
+bench_dtmf_burst (Bench *bench,
+    guint n_ops)
+{
+  TpyCallChannel *proxy;
+  GHashTable *properties;
+  GError *error = NULL;
+  guint i;
+
+  g_object_get (bench->chan, "channel-properties", &properties, NULL);
+  proxy = tpy_call_channel_new (bench->conn_proxy,
+      tp_base_channel_get_object_path (TP_BASE_CHANNEL (bench->chan)),
+      properties, &error);
+  g_hash_table_unref (properties);
+
+  if (proxy == NULL)
+    g_error ("Couldn't create the channel proxy: %s", error->message);
+
+  for (i = 0; i < n_ops; i++)
+    {
+      wait_for_replies (bench, WINDOW - 2);
+
+      bench->calls += 2;
+      tp_cli_channel_interface_dtmf_call_multiple_tones (TP_CHANNEL (proxy),
+          -1, "0123456789*#", channel_reply_cb, bench, NULL, NULL);
+      tp_cli_channel_interface_dtmf_call_stop_tone (TP_CHANNEL (proxy), -1,
+          0, channel_reply_cb, bench, NULL, NULL);
+    }
+
+  wait_for_replies (bench, 0);
+  g_object_unref (proxy);
+}
+
+/* setup runs on a new call before the clock starts */
+static const struct {
+    const gchar *name;
+    BenchSetupFunc setup;
+    BenchFunc func;
+} benchmarks[] = {
+    { "content-add-remove", NULL, bench_content_add_remove },
+    { "member-churn", add_steady_members, bench_member_churn },
+    { "member-churn-coalesced", add_steady_members_coalesced,
+      bench_member_churn },
+    { "add-candidates", NULL, bench_add_candidates },
+    { "endpoint-candidates", NULL, bench_endpoint_candidates },
+    { "codec-offer", answer_codec_offers, bench_codec_offer },
+    { "codec-offer-cached", answer_codec_offers_cached,
+      bench_codec_offer_cached },
+    { "dtmf-burst", NULL, bench_dtmf_burst },
+    { NULL, NULL, NULL }
+};
+
+static void
+report (const gchar *name,
+    guint n_ops,
+    gint64 elapsed,
+    guint64 allocs)
+{
+  struct rusage usage;
+  gdouble seconds = (gdouble) elapsed / G_USEC_PER_SEC;
+
+  getrusage (RUSAGE_SELF, &usage);
+
+  printf ("{\"benchmark\": \"%s\", \"ops\": %u, \"seconds\": %.6f, "
+      "\"ops_per_sec\": %.1f, ", name, n_ops, seconds,
+      seconds > 0 ? n_ops / seconds : 0.0);
+
+  if (allocs_counted)
+    printf ("\"allocs_per_op\": %.2f, ", (gdouble) allocs / n_ops);
+  else
+    printf ("\"allocs_per_op\": null, ");
+
+  printf ("\"peak_rss_kb\": %ld}\n", usage.ru_maxrss);
+  fflush (stdout);
+}
+
+static void
+run (Bench *bench,
+    const gchar *name,
+    BenchSetupFunc setup,
+    BenchFunc func,
+    guint n_ops)
+{
+  guint64 allocs;
+  gint64 start;
+
+  bench_start_call (bench);
+
+  if (setup != NULL)
+    setup (bench);
+
+  bench->calls = bench->replies = 0;
+
+  allocs = n_allocs;
+  start = g_get_monotonic_time ();
+
+  func (bench, n_ops);
+
+  report (name, n_ops, g_get_monotonic_time () - start, n_allocs - allocs);
+
+  bench_end_call (bench);
+}
+
+static gboolean
+wanted (const gchar *name,
+    gchar **names)
+{
+  return names == NULL || tp_strv_contains ((const gchar * const *) names,
+      name);
+}
+
+int
+main (int argc,
+    char **argv)
+{
+  static gint n_ops = 10000;
+  static gchar **names = NULL;
+  static GOptionEntry entries[] = {
+      { "ops", 'n', 0, G_OPTION_ARG_INT, &n_ops,
+        "Operations per benchmark (default 10000)", "N" },
+      { G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_STRING_ARRAY, &names,
+        NULL, "[BENCHMARK...]" },
+      { NULL }
+  };
+  GOptionContext *context;
+  Bench bench = { NULL, };
+  GError *error = NULL;
+  guint i;
+
+  /* Count every allocation, which GSlice would otherwise hide */
+  setenv ("G_SLICE", "always-malloc", TRUE);
+  g_mem_set_vtable (&counting_vtable);
+  allocs_counted = !g_mem_is_system_malloc ();
+
+  g_type_init ();
+  tpy_cli_init ();
+
+  context = g_option_context_new ("- benchmark the call base classes");
+  g_option_context_add_main_entries (context, entries, NULL);
+
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      fprintf (stderr, "%s\n", error->message);
+      return 2;
+    }
+
+  g_option_context_free (context);
+
+  if (n_ops <= 0)
+    {
+      fprintf (stderr, "--ops must be positive\n");
+      return 2;
+    }
+
+  bench.dbus = tp_dbus_daemon_dup (&error);
+
+  if (bench.dbus == NULL)
+    g_error ("Couldn't connect to the session bus: %s", error->message);
+
+  bench.conn = test_connection_new ("self@example.com");
+  test_connection_connect (bench.conn);
+  bench.peer = test_connection_ensure_contact (bench.conn,
+      "peer@example.com");
+
+  for (i = 0; i < WINDOW; i++)
+    {
+      gchar *id = g_strdup_printf ("guest%u@example.com", i);
+
+      bench.contacts[i] = test_connection_ensure_contact (bench.conn, id);
+      g_free (id);
+    }
+
+  bench.conn_proxy = tp_connection_new (bench.dbus,
+      TP_BASE_CONNECTION (bench.conn)->bus_name,
+      TP_BASE_CONNECTION (bench.conn)->object_path, &error);
+
+  if (bench.conn_proxy == NULL)
+    g_error ("Couldn't create the connection proxy: %s", error->message);
+
+  for (i = 0; benchmarks[i].name != NULL; i++)
+    {
+      if (wanted (benchmarks[i].name, names))
+        run (&bench, benchmarks[i].name, benchmarks[i].setup,
+            benchmarks[i].func, n_ops);
+    }
+
+  g_object_unref (bench.conn_proxy);
+  test_connection_disconnect (bench.conn);
+  drain ();
+  g_object_unref (bench.conn);
+  g_object_unref (bench.dbus);
+  g_strfreev (names);
+
+  return 0;
+}
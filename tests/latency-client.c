@@ -0,0 +1,513 @@
+/*
+ * latency-client.c - the client of the call setup benchmark
+ * Copyright © 2011 Collabora Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/* Answers each call latency-cm places with a TpyCallChannel, as a UI would,
+ * and times how long it takes to get through each phase of setting it up:
+ *
+ *   ready: the TpyCallChannel is ready, timed from NewChannels
+ *   accepted: Accept has returned
+ *   codecs-negotiated: CodecsChanged, once latency-engine has answered the
+ *    peer's codec offer
+ *   candidates-prepared: RemoteCandidatesAdded, with which the peer
+ *    answers CandidatesPrepared
+ *   connected: StreamStateChanged to Connected
+ *
+ * All but ready are timed from the Accept call, which leaves out the time
+ * spent here finding the objects to watch. Each call is hung up and closed
+ * once it is connected, and latency-cm then places the next one.
+ *
+ * Each phase prints one line of JSON, in microseconds:
+ *   {"phase": NAME, "calls": N, "p50_us": P50, "p99_us": P99,
+ *    "max_us": MAX}
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+
+#include <glib-object.h>
+
+#include <telepathy-glib/channel.h>
+#include <telepathy-glib/connection.h>
+#include <telepathy-glib/dbus.h>
+#include <telepathy-glib/enums.h>
+#include <telepathy-glib/errors.h>
+#include <telepathy-glib/interfaces.h>
+#include <telepathy-glib/proxy-subclass.h>
+#include <telepathy-glib/util.h>
+
+#include <telepathy-yell/call-channel.h>
+#include <telepathy-yell/call-content.h>
+#include <telepathy-yell/extensions.h>
+
+#include "latency.h"
+
+/* a call which isn't connected after this long has gone wrong */
+#define CALL_TIMEOUT 10
+
+typedef enum {
+    PHASE_READY,
+    PHASE_ACCEPTED,
+    PHASE_CODECS_NEGOTIATED,
+    PHASE_CANDIDATES_PREPARED,
+    PHASE_CONNECTED,
+    N_PHASES
+} Phase;
+
+static const gchar * const phase_names[N_PHASES] = {
+    "ready",
+    "accepted",
+    "codecs-negotiated",
+    "candidates-prepared",
+    "connected",
+};
+
+typedef struct {
+    /* calls to measure, after the first n_warmup */
+    guint n_calls;
+    guint n_warmup;
+
+    /* calls answered, and finished with */
+    guint n_answered;
+    guint n_finished;
+
+    /* microseconds to reach each phase, for each measured call */
+    GArray *latencies[N_PHASES];
+} Client;
+
+typedef struct {
+    Client *client;
+    /* the order in which it was answered */
+    guint serial;
+
+    TpyCallChannel *channel;
+    TpProxy *content;
+    TpProxy *stream;
+    TpProxy *endpoint;
+    GSList *signals;
+    guint timeout_id;
+
+    /* when NewChannels announced it, and when Accept was called */
+    gint64 announced;
+    gint64 accepting;
+    /* when each phase was reached, or 0 */
+    gint64 reached[N_PHASES];
+} ClientCall;
+
+static TpProxy *
+client_proxy_new (ClientCall *call,
+    const gchar *object_path,
+    GQuark iface)
+{
+  TpProxy *proxy = g_object_new (TP_TYPE_PROXY,
+      "dbus-daemon", tp_proxy_get_dbus_daemon (call->channel),
+      "bus-name", tp_proxy_get_bus_name (call->channel),
+      "object-path", object_path,
+      NULL);
+
+  tp_proxy_add_interface_by_id (proxy, iface);
+
+  return proxy;
+}
+
+static void
+client_call_take_signal (ClientCall *call,
+    TpProxySignalConnection *sc,
+    GError *error)
+{
+  if (sc == NULL)
+    g_error ("Couldn't connect to a signal: %s", error->message);
+
+  call->signals = g_slist_prepend (call->signals, sc);
+}
+
+static void
+client_call_free (ClientCall *call)
+{
+  g_slist_foreach (call->signals,
+      (GFunc) tp_proxy_signal_connection_disconnect, NULL);
+  g_slist_free (call->signals);
+
+  if (call->timeout_id != 0)
+    g_source_remove (call->timeout_id);
+
+  tp_clear_object (&call->endpoint);
+  tp_clear_object (&call->stream);
+  tp_clear_object (&call->content);
+  g_object_unref (call->channel);
+  g_slice_free (ClientCall, call);
+}
+
+static void
+closed_cb (TpChannel *channel,
+    const GError *error,
+    gpointer user_data,
+    GObject *weak_object)
+{
+  ClientCall *call = user_data;
+  Client *client = call->client;
+
+  /* Closed usually invalidates the channel before Close returns */
+  if (error != NULL && !g_error_matches (error, TP_DBUS_ERRORS,
+      TP_DBUS_ERROR_OBJECT_REMOVED))
+    g_error ("Couldn't close the call: %s", error->message);
+
+  client_call_free (call);
+
+  if (++client->n_finished == client->n_warmup + client->n_calls)
+    latency_quit ();
+}
+
+static void
+hangup_cb (GObject *source,
+    GAsyncResult *result,
+    gpointer user_data)
+{
+  ClientCall *call = user_data;
+  GError *error = NULL;
+
+  if (!tpy_call_channel_hangup_finish (call->channel, result, &error))
+    g_error ("Couldn't hang up: %s", error->message);
+
+  tp_cli_channel_call_close (TP_CHANNEL (call->channel), -1, closed_cb,
+      call, NULL, NULL);
+}
+
+static void
+client_call_reached (ClientCall *call,
+    Phase phase)
+{
+  Client *client = call->client;
+  guint i;
+
+  if (call->reached[phase] != 0)
+    return;
+
+  call->reached[phase] = g_get_monotonic_time ();
+
+  for (i = 0; i < N_PHASES; i++)
+    {
+      if (call->reached[i] == 0)
+        return;
+    }
+
+  g_source_remove (call->timeout_id);
+  call->timeout_id = 0;
+
+  if (call->serial >= client->n_warmup)
+    {
+      for (i = 0; i < N_PHASES; i++)
+        {
+          gint64 latency = call->reached[i] -
+              (i == PHASE_READY ? call->announced : call->accepting);
+
+          g_array_append_val (client->latencies[i], latency);
+        }
+    }
+
+  tpy_call_channel_hangup_async (call->channel,
+      TPY_CALL_STATE_CHANGE_REASON_USER_REQUESTED, "", "", hangup_cb, call);
+}
+
+static gboolean
+call_timeout_cb (gpointer user_data)
+{
+  ClientCall *call = user_data;
+  guint i;
+
+  for (i = 0; i < N_PHASES && call->reached[i] != 0; i++)
+    ;
+
+  g_error ("Call %u didn't get to %s within %u seconds", call->serial,
+      phase_names[i], CALL_TIMEOUT);
+
+  return FALSE;
+}
+
+static void
+accept_cb (GObject *source,
+    GAsyncResult *result,
+    gpointer user_data)
+{
+  ClientCall *call = user_data;
+  GError *error = NULL;
+
+  if (!tpy_call_channel_accept_finish (call->channel, result, &error))
+    g_error ("Couldn't accept the call: %s", error->message);
+
+  client_call_reached (call, PHASE_ACCEPTED);
+}
+
+static void
+codecs_changed_cb (TpProxy *proxy,
+    GHashTable *updated,
+    const GArray *removed,
+    gpointer user_data,
+    GObject *weak_object)
+{
+  client_call_reached (user_data, PHASE_CODECS_NEGOTIATED);
+}
+
+static void
+remote_candidates_added_cb (TpProxy *proxy,
+    const GPtrArray *candidates,
+    gpointer user_data,
+    GObject *weak_object)
+{
+  client_call_reached (user_data, PHASE_CANDIDATES_PREPARED);
+}
+
+static void
+stream_state_changed_cb (TpProxy *proxy,
+    guint state,
+    gpointer user_data,
+    GObject *weak_object)
+{
+  if (state == TP_MEDIA_STREAM_STATE_CONNECTED)
+    client_call_reached (user_data, PHASE_CONNECTED);
+}
+
+static void
+got_endpoints_cb (TpProxy *proxy,
+    const GValue *value,
+    const GError *error,
+    gpointer user_data,
+    GObject *weak_object)
+{
+  ClientCall *call = user_data;
+  GPtrArray *paths;
+  TpProxySignalConnection *sc;
+  GError *signal_error = NULL;
+
+  if (error != NULL)
+    g_error ("Couldn't get the endpoints: %s", error->message);
+
+  paths = g_value_get_boxed (value);
+
+  if (paths->len == 0)
+    g_error ("The stream has no endpoint");
+
+  call->endpoint = client_proxy_new (call, g_ptr_array_index (paths, 0),
+      TPY_IFACE_QUARK_CALL_STREAM_ENDPOINT);
+
+  sc = tpy_cli_call_stream_endpoint_connect_to_remote_candidates_added (
+      call->endpoint, remote_candidates_added_cb, call, NULL, NULL,
+      &signal_error);
+  client_call_take_signal (call, sc, signal_error);
+
+  sc = tpy_cli_call_stream_endpoint_connect_to_stream_state_changed (
+      call->endpoint, stream_state_changed_cb, call, NULL, NULL,
+      &signal_error);
+  client_call_take_signal (call, sc, signal_error);
+
+  call->accepting = g_get_monotonic_time ();
+  tpy_call_channel_accept_async (call->channel, accept_cb, call);
+}
+
+static void
+channel_ready_cb (TpyCallChannel *channel,
+    GParamSpec *pspec,
+    ClientCall *call)
+{
+  GPtrArray *contents;
+  TpyCallContent *content;
+  GList *streams;
+  TpProxySignalConnection *sc;
+  gboolean ready;
+  GError *error = NULL;
+
+  g_object_get (channel, "ready", &ready, "contents", &contents, NULL);
+
+  if (!ready)
+    {
+      g_ptr_array_unref (contents);
+      return;
+    }
+
+  client_call_reached (call, PHASE_READY);
+  g_signal_handlers_disconnect_by_func (channel, channel_ready_cb, call);
+
+  if (contents->len == 0)
+    g_error ("The call has no content");
+
+  /* latency-cm's calls have one audio content, with one stream */
+  content = g_ptr_array_index (contents, 0);
+  streams = tpy_call_content_get_streams (content);
+
+  if (streams == NULL)
+    g_error ("The content has no stream");
+
+  call->content = client_proxy_new (call,
+      tp_proxy_get_object_path (content),
+      TPY_IFACE_QUARK_CALL_CONTENT_INTERFACE_MEDIA);
+  call->stream = client_proxy_new (call,
+      tp_proxy_get_object_path (streams->data),
+      TPY_IFACE_QUARK_CALL_STREAM_INTERFACE_MEDIA);
+
+  g_ptr_array_unref (contents);
+
+  sc = tpy_cli_call_content_interface_media_connect_to_codecs_changed (
+      call->content, codecs_changed_cb, call, NULL, NULL, &error);
+  client_call_take_signal (call, sc, error);
+
+  tp_cli_dbus_properties_call_get (call->stream, -1,
+      TPY_IFACE_CALL_STREAM_INTERFACE_MEDIA, "Endpoints", got_endpoints_cb,
+      call, NULL, NULL);
+}
+
+static void
+answer_call (TpConnection *conn,
+    const gchar *object_path,
+    GHashTable *immutable_properties,
+    gpointer user_data)
+{
+  Client *client = user_data;
+  ClientCall *call;
+  GError *error = NULL;
+
+  /* latency-cm places one more call after the last one */
+  if (client->n_answered == client->n_warmup + client->n_calls)
+    return;
+
+  call = g_slice_new0 (ClientCall);
+  call->client = client;
+  call->serial = client->n_answered++;
+  call->announced = g_get_monotonic_time ();
+
+  call->channel = tpy_call_channel_new (conn, object_path,
+      immutable_properties, &error);
+
+  if (call->channel == NULL)
+    g_error ("Couldn't create the call: %s", error->message);
+
+  g_signal_connect (call->channel, "notify::ready",
+      G_CALLBACK (channel_ready_cb), call);
+  call->timeout_id = g_timeout_add_seconds (CALL_TIMEOUT, call_timeout_cb,
+      call);
+}
+
+static gint
+compare_latencies (gconstpointer a,
+    gconstpointer b)
+{
+  gint64 x = *(const gint64 *) a;
+  gint64 y = *(const gint64 *) b;
+
+  return x < y ? -1 : x > y;
+}
+
+/* the nearest-rank percentile of @sorted */
+static gint64
+percentile (GArray *sorted,
+    guint p)
+{
+  guint rank = (sorted->len * p + 99) / 100;
+
+  return g_array_index (sorted, gint64, MAX (rank, 1) - 1);
+}
+
+static void
+report (Client *client)
+{
+  guint i;
+
+  for (i = 0; i < N_PHASES; i++)
+    {
+      GArray *latencies = client->latencies[i];
+
+      g_array_sort (latencies, compare_latencies);
+
+      printf ("{\"phase\": \"%s\", \"calls\": %u, \"p50_us\": %"
+          G_GINT64_FORMAT ", \"p99_us\": %" G_GINT64_FORMAT ", \"max_us\": %"
+          G_GINT64_FORMAT "}\n", phase_names[i], latencies->len,
+          percentile (latencies, 50), percentile (latencies, 99),
+          g_array_index (latencies, gint64, latencies->len - 1));
+    }
+
+  fflush (stdout);
+}
+
+int
+main (int argc,
+    char **argv)
+{
+  static gint n_calls = 2000;
+  static gint n_warmup = 20;
+  static GOptionEntry entries[] = {
+      { "calls", 'n', 0, G_OPTION_ARG_INT, &n_calls,
+        "Calls to measure (default 2000)", "N" },
+      { "warmup", 'w', 0, G_OPTION_ARG_INT, &n_warmup,
+        "Calls to make first without measuring them (default 20)", "N" },
+      { NULL }
+  };
+  GOptionContext *context;
+  Client client = { 0, };
+  TpDBusDaemon *dbus;
+  GError *error = NULL;
+  gboolean finished;
+  guint i;
+
+  g_type_init ();
+  tpy_cli_init ();
+
+  context = g_option_context_new ("- time call setup through latency-cm "
+      "and latency-engine");
+  g_option_context_add_main_entries (context, entries, NULL);
+
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      fprintf (stderr, "%s\n", error->message);
+      return 2;
+    }
+
+  g_option_context_free (context);
+
+  if (n_calls <= 0 || n_warmup < 0)
+    {
+      fprintf (stderr, "--calls must be positive, and --warmup at least 0\n");
+      return 2;
+    }
+
+  client.n_calls = n_calls;
+  client.n_warmup = n_warmup;
+
+  for (i = 0; i < N_PHASES; i++)
+    client.latencies[i] = g_array_sized_new (FALSE, FALSE, sizeof (gint64),
+        client.n_calls);
+
+  dbus = tp_dbus_daemon_dup (&error);
+
+  if (dbus == NULL)
+    g_error ("Couldn't connect to the session bus: %s", error->message);
+
+  finished = latency_run (dbus, LATENCY_CLIENT_BUS_NAME, answer_call,
+      &client);
+
+  if (finished)
+    report (&client);
+  else
+    fprintf (stderr, "latency-cm left after %u calls\n", client.n_finished);
+
+  for (i = 0; i < N_PHASES; i++)
+    g_array_free (client.latencies[i], TRUE);
+
+  g_object_unref (dbus);
+
+  return finished ? 0 : 1;
+}
@@ -0,0 +1,159 @@
+/*
+ * latency-cm.c - the connection manager of the call setup benchmark
+ * Copyright © 2011 Collabora Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/* Places incoming calls from LATENCY_PEER on a TestConnection, one after
+ * the other: the first once latency-engine and latency-client are both on
+ * the bus, and each of the others once the previous one is closed. Exits
+ * when either of them leaves. */
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include <telepathy-glib/dbus.h>
+#include <telepathy-glib/util.h>
+
+#include "latency.h"
+#include "test-call.h"
+#include "test-connection.h"
+
+typedef struct {
+    TpDBusDaemon *dbus;
+    GMainLoop *loop;
+    TestConnection *conn;
+    TpHandle peer;
+
+    gboolean engine_present;
+    gboolean client_present;
+    /* whether calls are being placed */
+    gboolean started;
+
+    /* the call in progress; borrowed from conn */
+    TestCallChannel *call;
+    guint place_call_id;
+} LatencyCM;
+
+static void place_call (LatencyCM *cm);
+
+static gboolean
+place_call_idle (gpointer user_data)
+{
+  LatencyCM *cm = user_data;
+
+  cm->place_call_id = 0;
+  place_call (cm);
+
+  return FALSE;
+}
+
+static void
+call_closed_cb (TestCallChannel *call,
+    LatencyCM *cm)
+{
+  cm->call = NULL;
+
+  /* Let the channel finish closing first */
+  if (cm->started && cm->place_call_id == 0)
+    cm->place_call_id = g_idle_add (place_call_idle, cm);
+}
+
+static void
+place_call (LatencyCM *cm)
+{
+  if (cm->call != NULL)
+    return;
+
+  cm->call = test_call_channel_new (cm->conn, cm->peer, FALSE);
+  g_signal_connect (cm->call, "closed", G_CALLBACK (call_closed_cb), cm);
+
+  test_connection_announce_channel (cm->conn,
+      TP_EXPORTABLE_CHANNEL (cm->call));
+  /* The connection keeps the channel until it is closed */
+  g_object_unref (cm->call);
+}
+
+static void
+name_owner_changed_cb (TpDBusDaemon *dbus,
+    const gchar *name,
+    const gchar *new_owner,
+    gpointer user_data)
+{
+  LatencyCM *cm = user_data;
+  gboolean present = !tp_str_empty (new_owner);
+
+  if (!tp_strdiff (name, LATENCY_ENGINE_BUS_NAME))
+    cm->engine_present = present;
+  else
+    cm->client_present = present;
+
+  if (cm->started && !present)
+    {
+      g_main_loop_quit (cm->loop);
+    }
+  else if (!cm->started && cm->engine_present && cm->client_present)
+    {
+      cm->started = TRUE;
+      place_call (cm);
+    }
+}
+
+int
+main (int argc,
+    char **argv)
+{
+  LatencyCM cm = { NULL, };
+  GError *error = NULL;
+
+  g_type_init ();
+
+  cm.dbus = tp_dbus_daemon_dup (&error);
+
+  if (cm.dbus == NULL)
+    g_error ("Couldn't connect to the session bus: %s", error->message);
+
+  cm.loop = g_main_loop_new (NULL, FALSE);
+
+  cm.conn = test_connection_new (LATENCY_ACCOUNT);
+  test_connection_connect (cm.conn);
+  cm.peer = test_connection_ensure_contact (cm.conn, LATENCY_PEER);
+
+  tp_dbus_daemon_watch_name_owner (cm.dbus, LATENCY_ENGINE_BUS_NAME,
+      name_owner_changed_cb, &cm, NULL);
+  tp_dbus_daemon_watch_name_owner (cm.dbus, LATENCY_CLIENT_BUS_NAME,
+      name_owner_changed_cb, &cm, NULL);
+
+  g_main_loop_run (cm.loop);
+
+  tp_dbus_daemon_cancel_name_owner_watch (cm.dbus, LATENCY_ENGINE_BUS_NAME,
+      name_owner_changed_cb, &cm);
+  tp_dbus_daemon_cancel_name_owner_watch (cm.dbus, LATENCY_CLIENT_BUS_NAME,
+      name_owner_changed_cb, &cm);
+
+  cm.started = FALSE;
+
+  if (cm.place_call_id != 0)
+    g_source_remove (cm.place_call_id);
+
+  test_connection_disconnect (cm.conn);
+  g_object_unref (cm.conn);
+  g_main_loop_unref (cm.loop);
+  g_object_unref (cm.dbus);
+
+  return 0;
+}
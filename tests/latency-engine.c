@@ -0,0 +1,518 @@
+/*
+ * latency-engine.c - the streaming implementation of the call setup
+ *  benchmark
+ * Copyright © 2011 Collabora Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/* Handles each call latency-cm places as a streaming implementation would,
+ * without streaming anything: codec offers are accepted as they are, each
+ * stream gets its local candidates once the codecs are known, and is set
+ * connected as soon as remote candidates arrive. */
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include <telepathy-glib/channel.h>
+#include <telepathy-glib/connection.h>
+#include <telepathy-glib/dbus.h>
+#include <telepathy-glib/enums.h>
+#include <telepathy-glib/interfaces.h>
+#include <telepathy-glib/proxy-subclass.h>
+#include <telepathy-glib/util.h>
+
+#include <telepathy-yell/extensions.h>
+
+#include "latency.h"
+#include "test-call.h"
+
+/* local candidates gathered for each stream */
+#define N_CANDIDATES 2
+
+typedef struct _EngineCall EngineCall;
+typedef struct _EngineContent EngineContent;
+typedef struct _EngineStream EngineStream;
+
+/* A call being handled. Every D-Bus call made for it holds a reference, so
+ * that replies which arrive after the channel has closed are ignored
+ * rather than touching freed memory. */
+struct _EngineCall {
+    guint refcount;
+    TpChannel *channel;
+    gboolean closed;
+    GList *contents;
+    /* signal connections to the objects below, dropped once it closes */
+    GSList *signals;
+};
+
+struct _EngineContent {
+    EngineCall *call;
+    TpProxy *proxy;
+    /* the offer being answered, which can be seen both in the CodecOffer
+     * property and in NewCodecOffer */
+    gchar *offer;
+    gboolean codecs_accepted;
+    GList *streams;
+};
+
+struct _EngineStream {
+    EngineContent *content;
+    TpProxy *proxy;
+    TpProxy *endpoint;
+    gboolean candidates_added;
+    gboolean connected;
+};
+
+/* for the ports of the local candidates */
+static guint candidates_serial = 0;
+
+static TpProxy *
+engine_proxy_new (EngineCall *call,
+    const gchar *object_path,
+    GQuark iface)
+{
+  TpProxy *proxy = g_object_new (TP_TYPE_PROXY,
+      "dbus-daemon", tp_proxy_get_dbus_daemon (call->channel),
+      "bus-name", tp_proxy_get_bus_name (call->channel),
+      "object-path", object_path,
+      NULL);
+
+  tp_proxy_add_interface_by_id (proxy, iface);
+
+  return proxy;
+}
+
+static void
+engine_stream_free (gpointer data,
+    gpointer user_data)
+{
+  EngineStream *stream = data;
+
+  g_object_unref (stream->proxy);
+  tp_clear_object (&stream->endpoint);
+  g_slice_free (EngineStream, stream);
+}
+
+static void
+engine_content_free (gpointer data,
+    gpointer user_data)
+{
+  EngineContent *content = data;
+
+  g_list_foreach (content->streams, engine_stream_free, NULL);
+  g_list_free (content->streams);
+  g_object_unref (content->proxy);
+  g_free (content->offer);
+  g_slice_free (EngineContent, content);
+}
+
+static EngineCall *
+engine_call_ref (EngineCall *call)
+{
+  call->refcount++;
+
+  return call;
+}
+
+static void
+engine_call_unref (EngineCall *call)
+{
+  if (--call->refcount > 0)
+    return;
+
+  g_list_foreach (call->contents, engine_content_free, NULL);
+  g_list_free (call->contents);
+  g_object_unref (call->channel);
+  g_slice_free (EngineCall, call);
+}
+
+static void
+engine_call_take_signal (EngineCall *call,
+    TpProxySignalConnection *sc,
+    GError *error)
+{
+  if (sc == NULL)
+    g_error ("Couldn't connect to a signal: %s", error->message);
+
+  call->signals = g_slist_prepend (call->signals, sc);
+}
+
+/* Each D-Bus call made for a content or stream passes it as user_data,
+ * with one of these as its destroy notify */
+
+static gpointer
+content_hold (EngineContent *content)
+{
+  engine_call_ref (content->call);
+
+  return content;
+}
+
+static void
+content_release (gpointer data)
+{
+  engine_call_unref (((EngineContent *) data)->call);
+}
+
+static gpointer
+stream_hold (EngineStream *stream)
+{
+  engine_call_ref (stream->content->call);
+
+  return stream;
+}
+
+static void
+stream_release (gpointer data)
+{
+  engine_call_unref (((EngineStream *) data)->content->call);
+}
+
+static void
+stream_reply_cb (TpProxy *proxy,
+    const GError *error,
+    gpointer user_data,
+    GObject *weak_object)
+{
+  EngineStream *stream = user_data;
+
+  if (stream->content->call->closed)
+    return;
+
+  if (error != NULL)
+    g_error ("Call on %s failed: %s", tp_proxy_get_object_path (proxy),
+        error->message);
+}
+
+static void
+stream_add_candidates (EngineStream *stream)
+{
+  GPtrArray *candidates;
+
+  if (!stream->content->codecs_accepted || stream->endpoint == NULL ||
+      stream->candidates_added)
+    return;
+
+  stream->candidates_added = TRUE;
+
+  candidates = test_call_candidate_list_new (N_CANDIDATES,
+      candidates_serial++ * N_CANDIDATES);
+
+  tpy_cli_call_stream_interface_media_call_add_candidates (stream->proxy, -1,
+      candidates, stream_reply_cb, stream_hold (stream), stream_release,
+      NULL);
+  tpy_cli_call_stream_interface_media_call_candidates_prepared (
+      stream->proxy, -1, stream_reply_cb, stream_hold (stream),
+      stream_release, NULL);
+
+  g_boxed_free (TPY_ARRAY_TYPE_CANDIDATE_LIST, candidates);
+}
+
+static void
+remote_candidates_added_cb (TpProxy *proxy,
+    const GPtrArray *candidates,
+    gpointer user_data,
+    GObject *weak_object)
+{
+  EngineStream *stream = user_data;
+
+  if (stream->content->call->closed || stream->connected)
+    return;
+
+  stream->connected = TRUE;
+
+  tpy_cli_call_stream_endpoint_call_set_stream_state (stream->endpoint, -1,
+      TP_MEDIA_STREAM_STATE_CONNECTED, stream_reply_cb, stream_hold (stream),
+      stream_release, NULL);
+}
+
+static void
+got_endpoints_cb (TpProxy *proxy,
+    const GValue *value,
+    const GError *error,
+    gpointer user_data,
+    GObject *weak_object)
+{
+  EngineStream *stream = user_data;
+  EngineCall *call = stream->content->call;
+  GPtrArray *paths;
+  TpProxySignalConnection *sc;
+  GError *signal_error = NULL;
+
+  if (call->closed)
+    return;
+
+  if (error != NULL)
+    g_error ("Couldn't get the endpoints: %s", error->message);
+
+  /* In a one-to-one call, each stream has the one endpoint */
+  paths = g_value_get_boxed (value);
+
+  if (paths->len == 0)
+    return;
+
+  stream->endpoint = engine_proxy_new (call, g_ptr_array_index (paths, 0),
+      TPY_IFACE_QUARK_CALL_STREAM_ENDPOINT);
+
+  sc = tpy_cli_call_stream_endpoint_connect_to_remote_candidates_added (
+      stream->endpoint, remote_candidates_added_cb, stream, NULL, NULL,
+      &signal_error);
+  engine_call_take_signal (call, sc, signal_error);
+
+  stream_add_candidates (stream);
+}
+
+static void
+content_add_stream (EngineContent *content,
+    const gchar *object_path)
+{
+  EngineStream *stream = g_slice_new0 (EngineStream);
+
+  stream->content = content;
+  stream->proxy = engine_proxy_new (content->call, object_path,
+      TPY_IFACE_QUARK_CALL_STREAM_INTERFACE_MEDIA);
+  content->streams = g_list_prepend (content->streams, stream);
+
+  tp_cli_dbus_properties_call_get (stream->proxy, -1,
+      TPY_IFACE_CALL_STREAM_INTERFACE_MEDIA, "Endpoints", got_endpoints_cb,
+      stream_hold (stream), stream_release, NULL);
+}
+
+static void
+offer_accepted_cb (TpProxy *proxy,
+    const GError *error,
+    gpointer user_data,
+    GObject *weak_object)
+{
+  EngineContent *content = user_data;
+  GList *l;
+
+  /* The proxy was only kept for this call */
+  g_object_unref (proxy);
+
+  if (content->call->closed)
+    return;
+
+  if (error != NULL)
+    g_error ("Couldn't accept the codec offer: %s", error->message);
+
+  content->codecs_accepted = TRUE;
+
+  for (l = content->streams; l != NULL; l = l->next)
+    stream_add_candidates (l->data);
+}
+
+static void
+content_answer_offer (EngineContent *content,
+    const gchar *offer_path,
+    const GPtrArray *codecs)
+{
+  TpProxy *offer;
+
+  if (!tp_strdiff (content->offer, offer_path))
+    return;
+
+  g_free (content->offer);
+  content->offer = g_strdup (offer_path);
+
+  offer = engine_proxy_new (content->call, offer_path,
+      TPY_IFACE_QUARK_CALL_CONTENT_CODEC_OFFER);
+
+  /* Whatever the remote side can do will do */
+  tpy_cli_call_content_codec_offer_call_accept (offer, -1, codecs,
+      offer_accepted_cb, content_hold (content), content_release, NULL);
+}
+
+static void
+new_codec_offer_cb (TpProxy *proxy,
+    guint contact,
+    const gchar *offer_path,
+    const GPtrArray *codecs,
+    gpointer user_data,
+    GObject *weak_object)
+{
+  EngineContent *content = user_data;
+
+  if (!content->call->closed)
+    content_answer_offer (content, offer_path, codecs);
+}
+
+static void
+got_codec_offer_cb (TpProxy *proxy,
+    const GValue *value,
+    const GError *error,
+    gpointer user_data,
+    GObject *weak_object)
+{
+  EngineContent *content = user_data;
+  GValueArray *offering;
+  const gchar *offer_path;
+
+  if (content->call->closed)
+    return;
+
+  if (error != NULL)
+    g_error ("Couldn't get the codec offer: %s", error->message);
+
+  /* An offer made before NewCodecOffer was connected to */
+  offering = g_value_get_boxed (value);
+  offer_path = g_value_get_boxed (offering->values + 0);
+
+  if (tp_strdiff (offer_path, "/"))
+    content_answer_offer (content, offer_path,
+        g_value_get_boxed (offering->values + 2));
+}
+
+static void
+got_streams_cb (TpProxy *proxy,
+    const GValue *value,
+    const GError *error,
+    gpointer user_data,
+    GObject *weak_object)
+{
+  EngineContent *content = user_data;
+  GPtrArray *paths;
+  guint i;
+
+  if (content->call->closed)
+    return;
+
+  if (error != NULL)
+    g_error ("Couldn't get the streams: %s", error->message);
+
+  paths = g_value_get_boxed (value);
+
+  for (i = 0; i < paths->len; i++)
+    content_add_stream (content, g_ptr_array_index (paths, i));
+}
+
+static void
+call_add_content (EngineCall *call,
+    const gchar *object_path)
+{
+  EngineContent *content = g_slice_new0 (EngineContent);
+  TpProxySignalConnection *sc;
+  GError *error = NULL;
+
+  content->call = call;
+  content->proxy = engine_proxy_new (call, object_path,
+      TPY_IFACE_QUARK_CALL_CONTENT);
+  tp_proxy_add_interface_by_id (content->proxy,
+      TPY_IFACE_QUARK_CALL_CONTENT_INTERFACE_MEDIA);
+  call->contents = g_list_prepend (call->contents, content);
+
+  sc = tpy_cli_call_content_interface_media_connect_to_new_codec_offer (
+      content->proxy, new_codec_offer_cb, content, NULL, NULL, &error);
+  engine_call_take_signal (call, sc, error);
+
+  tp_cli_dbus_properties_call_get (content->proxy, -1,
+      TPY_IFACE_CALL_CONTENT_INTERFACE_MEDIA, "CodecOffer",
+      got_codec_offer_cb, content_hold (content), content_release, NULL);
+  tp_cli_dbus_properties_call_get (content->proxy, -1,
+      TPY_IFACE_CALL_CONTENT, "Streams", got_streams_cb,
+      content_hold (content), content_release, NULL);
+}
+
+static void
+got_contents_cb (TpProxy *proxy,
+    const GValue *value,
+    const GError *error,
+    gpointer user_data,
+    GObject *weak_object)
+{
+  EngineCall *call = user_data;
+  GPtrArray *paths;
+  guint i;
+
+  if (call->closed)
+    return;
+
+  if (error != NULL)
+    g_error ("Couldn't get the contents: %s", error->message);
+
+  paths = g_value_get_boxed (value);
+
+  for (i = 0; i < paths->len; i++)
+    call_add_content (call, g_ptr_array_index (paths, i));
+}
+
+static void
+channel_invalidated_cb (TpProxy *channel,
+    guint domain,
+    gint code,
+    gchar *message,
+    EngineCall *call)
+{
+  call->closed = TRUE;
+
+  g_slist_foreach (call->signals,
+      (GFunc) tp_proxy_signal_connection_disconnect, NULL);
+  g_slist_free (call->signals);
+  call->signals = NULL;
+
+  g_signal_handlers_disconnect_by_func (channel, channel_invalidated_cb,
+      call);
+  engine_call_unref (call);
+}
+
+static void
+handle_call (TpConnection *conn,
+    const gchar *object_path,
+    GHashTable *immutable_properties,
+    gpointer user_data)
+{
+  EngineCall *call = g_slice_new0 (EngineCall);
+  GError *error = NULL;
+
+  /* Released when the channel closes */
+  call->refcount = 1;
+  call->channel = tp_channel_new_from_properties (conn, object_path,
+      immutable_properties, &error);
+
+  if (call->channel == NULL)
+    g_error ("Couldn't create the channel proxy: %s", error->message);
+
+  g_signal_connect (call->channel, "invalidated",
+      G_CALLBACK (channel_invalidated_cb), call);
+
+  tp_cli_dbus_properties_call_get (call->channel, -1,
+      TPY_IFACE_CHANNEL_TYPE_CALL, "Contents", got_contents_cb,
+      engine_call_ref (call), (GDestroyNotify) engine_call_unref, NULL);
+}
+
+int
+main (int argc,
+    char **argv)
+{
+  TpDBusDaemon *dbus;
+  GError *error = NULL;
+
+  g_type_init ();
+  tpy_cli_init ();
+
+  dbus = tp_dbus_daemon_dup (&error);
+
+  if (dbus == NULL)
+    g_error ("Couldn't connect to the session bus: %s", error->message);
+
+  /* Runs until latency-cm leaves */
+  latency_run (dbus, LATENCY_ENGINE_BUS_NAME, handle_call, NULL);
+
+  g_object_unref (dbus);
+
+  return 0;
+}
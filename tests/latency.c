@@ -0,0 +1,162 @@
+/*
+ * latency.c - Source for what latency-engine and latency-client share
+ * Copyright © 2011 Collabora Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "latency.h"
+
+#include <telepathy-glib/dbus.h>
+#include <telepathy-glib/interfaces.h>
+#include <telepathy-glib/util.h>
+
+#include <telepathy-yell/interfaces.h>
+
+typedef struct {
+    TpDBusDaemon *dbus;
+    const gchar *own_name;
+    LatencyCallFunc func;
+    gpointer user_data;
+
+    TpConnection *conn;
+    GMainLoop *loop;
+    /* whether latency-cm left before latency_quit() was called */
+    gboolean cm_left;
+} LatencyRun;
+
+static GMainLoop *running_loop = NULL;
+
+static void
+new_channels_cb (TpConnection *conn,
+    const GPtrArray *channels,
+    gpointer user_data,
+    GObject *weak_object)
+{
+  LatencyRun *run = user_data;
+  guint i;
+
+  for (i = 0; i < channels->len; i++)
+    {
+      GValueArray *channel = g_ptr_array_index (channels, i);
+      const gchar *path = g_value_get_boxed (channel->values + 0);
+      GHashTable *properties = g_value_get_boxed (channel->values + 1);
+
+      if (!tp_strdiff (tp_asv_get_string (properties,
+          TP_PROP_CHANNEL_CHANNEL_TYPE), TPY_IFACE_CHANNEL_TYPE_CALL))
+        run->func (conn, path, properties, run->user_data);
+    }
+}
+
+static void
+conn_prepared_cb (GObject *source,
+    GAsyncResult *result,
+    gpointer user_data)
+{
+  LatencyRun *run = user_data;
+  GError *error = NULL;
+
+  if (!tp_proxy_prepare_finish (source, result, &error))
+    g_error ("Couldn't prepare the connection: %s", error->message);
+
+  if (tp_cli_connection_interface_requests_connect_to_new_channels (
+      run->conn, new_channels_cb, run, NULL, NULL, &error) == NULL)
+    g_error ("Couldn't connect to NewChannels: %s", error->message);
+
+  /* latency-cm starts placing calls once everyone has taken their name */
+  if (!tp_dbus_daemon_request_name (run->dbus, run->own_name, FALSE,
+      &error))
+    g_error ("Couldn't take %s: %s", run->own_name, error->message);
+}
+
+static void
+cm_owner_changed_cb (TpDBusDaemon *dbus,
+    const gchar *name,
+    const gchar *new_owner,
+    gpointer user_data)
+{
+  LatencyRun *run = user_data;
+  GError *error = NULL;
+
+  if (tp_str_empty (new_owner))
+    {
+      if (run->conn != NULL)
+        {
+          run->cm_left = TRUE;
+          g_main_loop_quit (run->loop);
+        }
+
+      return;
+    }
+
+  if (run->conn != NULL)
+    return;
+
+  run->conn = tp_connection_new (dbus, new_owner, LATENCY_CONN_OBJECT_PATH,
+      &error);
+
+  if (run->conn == NULL)
+    g_error ("Couldn't create the connection proxy: %s", error->message);
+
+  tp_proxy_prepare_async (run->conn, NULL, conn_prepared_cb, run);
+}
+
+/**
+ * latency_run:
+ * @dbus: the session bus
+ * @own_name: the name to take once @func is ready to be called
+ * @func: called with each call latency-cm places
+ * @user_data: passed to @func
+ *
+ * Waits for latency-cm, then runs the main loop until latency_quit() is
+ * called or latency-cm leaves the bus.
+ *
+ * Returns: %FALSE if latency-cm left first
+ */
+gboolean
+latency_run (TpDBusDaemon *dbus,
+    const gchar *own_name,
+    LatencyCallFunc func,
+    gpointer user_data)
+{
+  LatencyRun run = { dbus, own_name, func, user_data, NULL, NULL, FALSE };
+
+  g_return_val_if_fail (running_loop == NULL, FALSE);
+
+  run.loop = running_loop = g_main_loop_new (NULL, FALSE);
+
+  tp_dbus_daemon_watch_name_owner (dbus, LATENCY_CONN_BUS_NAME,
+      cm_owner_changed_cb, &run, NULL);
+
+  g_main_loop_run (run.loop);
+
+  tp_dbus_daemon_cancel_name_owner_watch (dbus, LATENCY_CONN_BUS_NAME,
+      cm_owner_changed_cb, &run);
+  tp_dbus_daemon_release_name (dbus, own_name, NULL);
+
+  tp_clear_object (&run.conn);
+  g_main_loop_unref (run.loop);
+  running_loop = NULL;
+
+  return !run.cm_left;
+}
+
+void
+latency_quit (void)
+{
+  g_return_if_fail (running_loop != NULL);
+
+  g_main_loop_quit (running_loop);
+}
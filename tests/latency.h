@@ -0,0 +1,57 @@
+/*
+ * latency.h - Header for the call setup latency benchmark
+ * Copyright © 2011 Collabora Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __LATENCY_H__
+#define __LATENCY_H__
+
+#include <glib.h>
+#include <telepathy-glib/connection.h>
+#include <telepathy-glib/defs.h>
+
+G_BEGIN_DECLS
+
+/* latency-cm, latency-engine and latency-client find each other by these
+ * names on the session bus */
+
+#define LATENCY_ACCOUNT "self@example.com"
+#define LATENCY_PEER "peer@example.com"
+
+/* where TestConnection registers itself for LATENCY_ACCOUNT */
+#define LATENCY_CONN_BUS_NAME \
+  TP_CONN_BUS_NAME_BASE "yell.test.self_40example_2ecom"
+#define LATENCY_CONN_OBJECT_PATH \
+  TP_CONN_OBJECT_PATH_BASE "yell/test/self_40example_2ecom"
+
+#define LATENCY_ENGINE_BUS_NAME TP_CLIENT_BUS_NAME_BASE "YellLatencyEngine"
+#define LATENCY_CLIENT_BUS_NAME TP_CLIENT_BUS_NAME_BASE "YellLatencyClient"
+
+typedef void (*LatencyCallFunc) (TpConnection *conn,
+    const gchar *object_path,
+    GHashTable *immutable_properties,
+    gpointer user_data);
+
+gboolean latency_run (TpDBusDaemon *dbus,
+    const gchar *own_name,
+    LatencyCallFunc func,
+    gpointer user_data);
+void latency_quit (void);
+
+G_END_DECLS
+
+#endif /* #ifndef __LATENCY_H__*/
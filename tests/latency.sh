@@ -0,0 +1,22 @@
+#!/bin/sh
+# latency.sh - run the call setup latency benchmark on the session bus
+#
+# latency-cm and latency-engine exit by themselves once latency-client,
+# which prints the results and takes any options given here, has left the
+# bus.
+
+./latency-cm &
+cm=$!
+./latency-engine &
+engine=$!
+
+e=0
+./latency-client "$@" || e=$?
+
+if test $e = 0; then
+  wait $cm $engine || e=$?
+else
+  kill $cm $engine 2>/dev/null
+fi
+
+exit $e
@@ -0,0 +1,426 @@
+/*
+ * test-call-async.c - overlapping async operations on the Call proxies
+ * Copyright © 2011 Collabora Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/* Fires accept, set-sending, request-receiving, remove and hangup at a call
+ * on a TestConnection without waiting for any of them to return, and checks
+ * that each completes exactly once, on its own object, with its own
+ * result. */
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include <telepathy-glib/connection.h>
+#include <telepathy-glib/dbus.h>
+#include <telepathy-glib/errors.h>
+#include <telepathy-glib/util.h>
+
+#include <telepathy-yell/call-channel.h>
+#include <telepathy-yell/call-content.h>
+#include <telepathy-yell/call-stream.h>
+#include <telepathy-yell/extensions.h>
+
+#include "test-call.h"
+#include "test-connection.h"
+
+/* calls set up and torn down by each test */
+#define N_ROUNDS 50
+/* SetSending calls in flight at once */
+#define N_SET_SENDING 8
+/* the most operations fired at one call */
+#define MAX_OPS (N_SET_SENDING + 8)
+
+typedef gboolean (*FinishFunc) (GObject *source,
+    GAsyncResult *result,
+    GError **error);
+
+typedef struct {
+    TpDBusDaemon *dbus;
+    TestConnection *conn;
+    TpConnection *conn_proxy;
+    TpHandle peer;
+
+    /* the call of the current round, on both sides */
+    TestCallChannel *chan;
+    TpyCallChannel *proxy;
+
+    /* operations fired at it which haven't finished yet */
+    guint pending;
+} Test;
+
+typedef struct {
+    Test *test;
+    GObject *source;
+    FinishFunc finish;
+    /* the TP_ERRORS code it should fail with, or -1 */
+    gint expected_error;
+    gboolean done;
+} Op;
+
+static gboolean
+accept_finish (GObject *source,
+    GAsyncResult *result,
+    GError **error)
+{
+  return tpy_call_channel_accept_finish (TPY_CALL_CHANNEL (source), result,
+      error);
+}
+
+static gboolean
+hangup_finish (GObject *source,
+    GAsyncResult *result,
+    GError **error)
+{
+  return tpy_call_channel_hangup_finish (TPY_CALL_CHANNEL (source), result,
+      error);
+}
+
+static gboolean
+set_sending_finish (GObject *source,
+    GAsyncResult *result,
+    GError **error)
+{
+  return tpy_call_stream_set_sending_finish (TPY_CALL_STREAM (source),
+      result, error);
+}
+
+static gboolean
+request_receiving_finish (GObject *source,
+    GAsyncResult *result,
+    GError **error)
+{
+  return tpy_call_stream_request_receiving_finish (TPY_CALL_STREAM (source),
+      result, error);
+}
+
+static gboolean
+remove_finish (GObject *source,
+    GAsyncResult *result,
+    GError **error)
+{
+  return tpy_call_content_remove_finish (TPY_CALL_CONTENT (source), result,
+      error);
+}
+
+static void
+op_done_cb (GObject *source,
+    GAsyncResult *result,
+    gpointer user_data)
+{
+  Op *op = user_data;
+  GError *error = NULL;
+  gboolean ok;
+
+  g_assert (!op->done);
+  g_assert (source == op->source);
+
+  ok = op->finish (source, result, &error);
+
+  if (op->expected_error < 0)
+    {
+      g_assert_no_error (error);
+      g_assert (ok);
+    }
+  else
+    {
+      g_assert_error (error, TP_ERRORS, op->expected_error);
+      g_assert (!ok);
+      g_clear_error (&error);
+    }
+
+  op->done = TRUE;
+  op->test->pending--;
+}
+
+static Op *
+op_init (Op *op,
+    Test *test,
+    gpointer source,
+    FinishFunc finish,
+    gint expected_error)
+{
+  op->test = test;
+  op->source = source;
+  op->finish = finish;
+  op->expected_error = expected_error;
+  op->done = FALSE;
+
+  test->pending++;
+
+  return op;
+}
+
+static void
+drain (void)
+{
+  while (g_main_context_iteration (NULL, FALSE))
+    ;
+}
+
+static void
+setup (Test *test,
+    gconstpointer data)
+{
+  GError *error = NULL;
+
+  test->dbus = tp_dbus_daemon_dup (&error);
+  g_assert_no_error (error);
+
+  test->conn = test_connection_new ("self@example.com");
+  test_connection_connect (test->conn);
+  test->peer = test_connection_ensure_contact (test->conn,
+      "peer@example.com");
+
+  test->conn_proxy = tp_connection_new (test->dbus,
+      TP_BASE_CONNECTION (test->conn)->bus_name,
+      TP_BASE_CONNECTION (test->conn)->object_path, &error);
+  g_assert_no_error (error);
+}
+
+static void
+teardown (Test *test,
+    gconstpointer data)
+{
+  g_object_unref (test->conn_proxy);
+  test_connection_disconnect (test->conn);
+  drain ();
+  g_object_unref (test->conn);
+  g_object_unref (test->dbus);
+}
+
+/* An incoming call with an audio and a video content, and a ready proxy
+ * for it */
+static void
+start_call (Test *test)
+{
+  GHashTable *properties;
+  gboolean ready = FALSE;
+  GError *error = NULL;
+
+  test->chan = test_call_channel_new (test->conn, test->peer, FALSE);
+  test_call_channel_add_content (test->chan, "video",
+      TP_MEDIA_STREAM_TYPE_VIDEO);
+  test_connection_announce_channel (test->conn,
+      TP_EXPORTABLE_CHANNEL (test->chan));
+  /* The connection keeps the channel until it is closed */
+  g_object_unref (test->chan);
+
+  g_object_get (test->chan, "channel-properties", &properties, NULL);
+  test->proxy = tpy_call_channel_new (test->conn_proxy,
+      tp_base_channel_get_object_path (TP_BASE_CHANNEL (test->chan)),
+      properties, &error);
+  g_assert_no_error (error);
+  g_hash_table_unref (properties);
+
+  while (!ready)
+    {
+      g_main_context_iteration (NULL, TRUE);
+      g_object_get (test->proxy, "ready", &ready, NULL);
+    }
+}
+
+static void
+end_call (Test *test)
+{
+  TP_BASE_CHANNEL_GET_CLASS (test->chan)->close (
+      TP_BASE_CHANNEL (test->chan));
+  test->chan = NULL;
+  tp_clear_object (&test->proxy);
+
+  drain ();
+}
+
+static TpyCallContent *
+lookup_content (Test *test,
+    const gchar *name)
+{
+  GPtrArray *contents;
+  TpyCallContent *found = NULL;
+  guint i;
+
+  g_object_get (test->proxy, "contents", &contents, NULL);
+
+  for (i = 0; i < contents->len; i++)
+    {
+      TpyCallContent *content = g_ptr_array_index (contents, i);
+
+      if (!tp_strdiff (tpy_call_content_get_name (content), name))
+        found = content;
+    }
+
+  g_ptr_array_unref (contents);
+  g_assert (found != NULL);
+
+  /* still owned by the channel proxy */
+  return found;
+}
+
+/* The audio stream's local sending state, as the service has it */
+static TpySendingState
+local_sending_state (Test *test)
+{
+  GList *l;
+
+  for (l = tpy_base_call_channel_get_contents (
+          TPY_BASE_CALL_CHANNEL (test->chan));
+      l != NULL; l = l->next)
+    {
+      if (!tp_strdiff (tpy_base_call_content_get_name (l->data), "audio"))
+        break;
+    }
+
+  g_assert (l != NULL);
+
+  return tpy_base_call_stream_get_local_sending_state (
+      TPY_BASE_CALL_STREAM (test_call_content_get_stream (
+          TPY_BASE_MEDIA_CALL_CONTENT (l->data))));
+}
+
+static void
+wait_for_ops (Test *test,
+    Op *ops,
+    guint n_ops)
+{
+  guint i;
+
+  while (test->pending > 0)
+    g_main_context_iteration (NULL, TRUE);
+
+  for (i = 0; i < n_ops; i++)
+    g_assert (ops[i].done);
+}
+
+/* Every operation the proxies have, all at once, in an order the service
+ * has a definite answer for */
+static void
+test_overlapping (Test *test,
+    gconstpointer data)
+{
+  guint round;
+
+  for (round = 0; round < N_ROUNDS; round++)
+    {
+      Op ops[MAX_OPS];
+      guint n_ops = 0;
+      TpyCallContent *audio, *video;
+      TpyCallStream *stream;
+      guint i;
+
+      start_call (test);
+
+      audio = lookup_content (test, "audio");
+      video = lookup_content (test, "video");
+      stream = tpy_call_content_get_streams (audio)->data;
+
+      /* The second Accept finds the call already accepted */
+      tpy_call_channel_accept_async (test->proxy, op_done_cb,
+          op_init (&ops[n_ops++], test, test->proxy, accept_finish, -1));
+      tpy_call_channel_accept_async (test->proxy, op_done_cb,
+          op_init (&ops[n_ops++], test, test->proxy, accept_finish,
+              TP_ERROR_NOT_AVAILABLE));
+
+      for (i = 0; i < N_SET_SENDING; i++)
+        tpy_call_stream_set_sending_async (stream, i % 2 == 0, op_done_cb,
+            op_init (&ops[n_ops++], test, stream, set_sending_finish, -1));
+
+      /* TestCallStream has no request_receiving */
+      tpy_call_stream_request_receiving_async (stream, test->peer, TRUE,
+          op_done_cb, op_init (&ops[n_ops++], test, stream,
+              request_receiving_finish, TP_ERROR_NOT_IMPLEMENTED));
+
+      tpy_call_content_remove_async (video,
+          TPY_CONTENT_REMOVAL_REASON_USER_REQUESTED, "", "", op_done_cb,
+          op_init (&ops[n_ops++], test, video, remove_finish, -1));
+
+      tpy_call_channel_hangup_async (test->proxy,
+          TPY_CALL_STATE_CHANGE_REASON_USER_REQUESTED, "", "", op_done_cb,
+          op_init (&ops[n_ops++], test, test->proxy, hangup_finish, -1));
+
+      g_assert_cmpuint (n_ops, <=, MAX_OPS);
+      wait_for_ops (test, ops, n_ops);
+
+      /* The service saw them in the order they were made */
+      g_assert_cmpuint (tpy_base_call_channel_get_state (
+          TPY_BASE_CALL_CHANNEL (test->chan)), ==, TPY_CALL_STATE_ENDED);
+      g_assert_cmpuint (g_list_length (tpy_base_call_channel_get_contents (
+          TPY_BASE_CALL_CHANNEL (test->chan))), ==, 1);
+      g_assert_cmpuint (local_sending_state (test), ==,
+          TPY_SENDING_STATE_NONE);
+
+      end_call (test);
+    }
+}
+
+/* Hanging up while operations on the call's objects are still in flight,
+ * and only then waiting for all of them */
+static void
+test_hangup_first (Test *test,
+    gconstpointer data)
+{
+  guint round;
+
+  for (round = 0; round < N_ROUNDS; round++)
+    {
+      Op ops[MAX_OPS];
+      guint n_ops = 0;
+      TpyCallStream *stream;
+      guint i;
+
+      start_call (test);
+
+      stream = tpy_call_content_get_streams (
+          lookup_content (test, "audio"))->data;
+
+      tpy_call_channel_hangup_async (test->proxy,
+          TPY_CALL_STATE_CHANGE_REASON_USER_REQUESTED, "", "", op_done_cb,
+          op_init (&ops[n_ops++], test, test->proxy, hangup_finish, -1));
+
+      for (i = 0; i < N_SET_SENDING; i++)
+        tpy_call_stream_set_sending_async (stream, i % 2 == 1, op_done_cb,
+            op_init (&ops[n_ops++], test, stream, set_sending_finish, -1));
+
+      /* An ended call can't be accepted */
+      tpy_call_channel_accept_async (test->proxy, op_done_cb,
+          op_init (&ops[n_ops++], test, test->proxy, accept_finish,
+              TP_ERROR_NOT_AVAILABLE));
+
+      wait_for_ops (test, ops, n_ops);
+
+      g_assert_cmpuint (local_sending_state (test), ==,
+          TPY_SENDING_STATE_SENDING);
+
+      end_call (test);
+    }
+}
+
+int
+main (int argc,
+    char **argv)
+{
+  g_type_init ();
+  g_test_init (&argc, &argv, NULL);
+  tpy_cli_init ();
+
+  g_test_add ("/call-async/overlapping", Test, NULL, setup,
+      test_overlapping, teardown);
+  g_test_add ("/call-async/hangup-first", Test, NULL, setup,
+      test_hangup_first, teardown);
+
+  return g_test_run ();
+}
@@ -0,0 +1,365 @@
+/*
+ * test-call.c - Source for the stub call channel and stream
+ * Copyright © 2011 Collabora Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/* The least a connection manager has to add to the base classes to get a
+ * working call: contents with one stream and one endpoint each, which
+ * accept every candidate they are given. The peer is played by the
+ * channel itself: it offers its codecs as soon as the call is accepted, and
+ * answers the local candidates with its own once they are prepared. */
+
+#include "test-call.h"
+
+#include <telepathy-glib/base-channel.h>
+#include <telepathy-glib/dbus.h>
+#include <telepathy-glib/gtypes.h>
+#include <telepathy-glib/interfaces.h>
+#include <telepathy-glib/util.h>
+
+#include <telepathy-yell/enums.h>
+#include <telepathy-yell/gtypes.h>
+
+/* what the peer offers */
+#define PEER_CODECS 4
+#define PEER_CANDIDATES 2
+
+/* TestCallStream */
+
+G_DEFINE_TYPE (TestCallStream, test_call_stream,
+    TPY_TYPE_BASE_MEDIA_CALL_STREAM);
+
+static void
+test_call_stream_init (TestCallStream *self)
+{
+}
+
+static GPtrArray *
+test_call_stream_add_local_candidates (TpyBaseMediaCallStream *self,
+    const GPtrArray *candidates,
+    GError **error)
+{
+  return g_boxed_copy (TPY_ARRAY_TYPE_CANDIDATE_LIST, candidates);
+}
+
+static void
+test_call_stream_local_candidates_prepared (TpyBaseMediaCallStream *self)
+{
+  TestCallStream *stream = TEST_CALL_STREAM (self);
+  GList *l;
+
+  stream->candidates_prepared++;
+
+  for (l = tpy_base_media_call_stream_get_endpoints (self); l != NULL;
+      l = l->next)
+    {
+      GPtrArray *candidates = test_call_candidate_list_new (PEER_CANDIDATES,
+          stream->candidates_prepared * PEER_CANDIDATES);
+
+      tpy_call_stream_endpoint_add_new_candidates (l->data, candidates);
+      g_boxed_free (TPY_ARRAY_TYPE_CANDIDATE_LIST, candidates);
+    }
+}
+
+static gboolean
+test_call_stream_set_sending (TpyBaseCallStream *self,
+    gboolean sending,
+    GError **error)
+{
+  return TRUE;
+}
+
+static void
+test_call_stream_class_init (TestCallStreamClass *klass)
+{
+  TpyBaseCallStreamClass *bcs_class = TPY_BASE_CALL_STREAM_CLASS (klass);
+  TpyBaseMediaCallStreamClass *bmcs_class =
+      TPY_BASE_MEDIA_CALL_STREAM_CLASS (klass);
+
+  bcs_class->set_sending = test_call_stream_set_sending;
+  bmcs_class->add_local_candidates = test_call_stream_add_local_candidates;
+  bmcs_class->local_candidates_prepared =
+      test_call_stream_local_candidates_prepared;
+}
+
+TpyCallStreamEndpoint *
+test_call_stream_get_endpoint (TestCallStream *self)
+{
+  GList *endpoints = tpy_base_media_call_stream_get_endpoints (
+      TPY_BASE_MEDIA_CALL_STREAM (self));
+
+  g_return_val_if_fail (endpoints != NULL, NULL);
+
+  return endpoints->data;
+}
+
+/* TestCallChannel */
+
+G_DEFINE_TYPE (TestCallChannel, test_call_channel,
+    TPY_TYPE_BASE_CALL_CHANNEL);
+
+static const gchar *test_call_channel_interfaces[] = {
+    TP_IFACE_CHANNEL_INTERFACE_DTMF,
+    NULL
+};
+
+struct _TestCallChannelPrivate
+{
+  guint content_serial;
+};
+
+static void
+test_call_channel_init (TestCallChannel *self)
+{
+  self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self, TEST_TYPE_CALL_CHANNEL,
+      TestCallChannelPrivate);
+}
+
+static gchar *
+test_call_channel_get_object_path_suffix (TpBaseChannel *base)
+{
+  static guint serial = 0;
+
+  return g_strdup_printf ("CallChannel%u", serial++);
+}
+
+static void
+test_call_channel_accept (TpyBaseCallChannel *base)
+{
+  TpHandle peer = tp_base_channel_get_target_handle (TP_BASE_CHANNEL (base));
+  GPtrArray *codecs = test_call_codec_list_new (PEER_CODECS, 0);
+  GList *l;
+
+  for (l = tpy_base_call_channel_get_contents (base); l != NULL; l = l->next)
+    tpy_base_media_call_content_offer_codecs (l->data, peer, codecs);
+
+  g_boxed_free (TPY_ARRAY_TYPE_CODEC_LIST, codecs);
+}
+
+static TpyBaseCallContent *
+test_call_channel_add_content_dbus (TpyBaseCallChannel *base,
+    const gchar *name,
+    TpMediaStreamType media,
+    GError **error)
+{
+  return TPY_BASE_CALL_CONTENT (test_call_channel_add_content (
+      TEST_CALL_CHANNEL (base), name, media));
+}
+
+static void
+test_call_channel_class_init (TestCallChannelClass *klass)
+{
+  TpBaseChannelClass *base_class = TP_BASE_CHANNEL_CLASS (klass);
+  TpyBaseCallChannelClass *bcc_class = TPY_BASE_CALL_CHANNEL_CLASS (klass);
+
+  g_type_class_add_private (klass, sizeof (TestCallChannelPrivate));
+
+  base_class->target_handle_type = TP_HANDLE_TYPE_CONTACT;
+  base_class->interfaces = test_call_channel_interfaces;
+  base_class->get_object_path_suffix =
+      test_call_channel_get_object_path_suffix;
+
+  bcc_class->accept = test_call_channel_accept;
+  bcc_class->add_content = test_call_channel_add_content_dbus;
+}
+
+/**
+ * test_call_channel_new:
+ * @conn: a connected #TestConnection
+ * @peer: the remote contact
+ * @requested: %TRUE for an outgoing call, %FALSE for an incoming one
+ *
+ * Returns: a new call with @peer, with an audio content and @peer as its
+ *  only member. It is not registered until it is announced with
+ *  test_connection_announce_channel().
+ */
+TestCallChannel *
+test_call_channel_new (TestConnection *conn,
+    TpHandle peer,
+    gboolean requested)
+{
+  TpBaseConnection *base_conn = TP_BASE_CONNECTION (conn);
+  TestCallChannel *self;
+
+  self = g_object_new (TEST_TYPE_CALL_CHANNEL,
+      "connection", conn,
+      "handle", peer,
+      "initiator-handle", requested ? base_conn->self_handle : peer,
+      "requested", requested,
+      "initial-audio", TRUE,
+      "initial-audio-name", "audio",
+      NULL);
+
+  test_call_channel_add_content (self, "audio", TP_MEDIA_STREAM_TYPE_AUDIO);
+  tpy_base_call_channel_add_member (TPY_BASE_CALL_CHANNEL (self), peer, 0);
+
+  return self;
+}
+
+/**
+ * test_call_channel_add_content:
+ * @self: a #TestCallChannel
+ * @name: the name of the new content
+ * @media: its media type
+ *
+ * Returns: (transfer none): a new content with one stream, which has one
+ *  endpoint, already added to @self
+ */
+TpyBaseMediaCallContent *
+test_call_channel_add_content (TestCallChannel *self,
+    const gchar *name,
+    TpMediaStreamType media)
+{
+  TpBaseChannel *base = TP_BASE_CHANNEL (self);
+  TpBaseConnection *conn = tp_base_channel_get_connection (base);
+  TpyBaseMediaCallContent *content;
+  TestCallStream *stream;
+  TpyCallStreamEndpoint *endpoint;
+  gchar *path;
+  gchar *stream_path;
+  gchar *endpoint_path;
+
+  path = g_strdup_printf ("%s/Content%u", tp_base_channel_get_object_path (
+      base), self->priv->content_serial++);
+  stream_path = g_strdup_printf ("%s/Stream", path);
+  endpoint_path = g_strdup_printf ("%s/Endpoint", stream_path);
+
+  content = g_object_new (TPY_TYPE_BASE_MEDIA_CALL_CONTENT,
+      "connection", conn,
+      "object-path", path,
+      "name", name,
+      "media-type", media,
+      "creator", conn->self_handle,
+      "disposition", tp_base_channel_is_registered (base)
+          ? TPY_CALL_CONTENT_DISPOSITION_NONE
+          : TPY_CALL_CONTENT_DISPOSITION_INITIAL,
+      NULL);
+
+  stream = g_object_new (TEST_TYPE_CALL_STREAM,
+      "connection", conn,
+      "object-path", stream_path,
+      NULL);
+
+  endpoint = tpy_call_stream_endpoint_new (
+      tp_base_connection_get_dbus_daemon (conn), endpoint_path,
+      TPY_STREAM_TRANSPORT_TYPE_RAW_UDP);
+  tpy_base_media_call_stream_take_endpoint (
+      TPY_BASE_MEDIA_CALL_STREAM (stream), endpoint);
+
+  tpy_base_call_content_add_stream (TPY_BASE_CALL_CONTENT (content),
+      TPY_BASE_CALL_STREAM (stream));
+  g_object_unref (stream);
+
+  tpy_base_call_channel_add_content (TPY_BASE_CALL_CHANNEL (self),
+      TPY_BASE_CALL_CONTENT (content));
+
+  g_free (endpoint_path);
+  g_free (stream_path);
+  g_free (path);
+
+  return content;
+}
+
+/**
+ * test_call_content_get_stream:
+ * @content: a content created by test_call_channel_add_content()
+ *
+ * Returns: (transfer none): the stream of @content
+ */
+TestCallStream *
+test_call_content_get_stream (TpyBaseMediaCallContent *content)
+{
+  GList *streams = tpy_base_call_content_get_streams (
+      TPY_BASE_CALL_CONTENT (content));
+
+  g_return_val_if_fail (streams != NULL, NULL);
+
+  return TEST_CALL_STREAM (streams->data);
+}
+
+/**
+ * test_call_codec_list_new:
+ * @n_codecs: the number of codecs
+ * @variant: lists with different @variant have different codec names
+ *
+ * Returns: a new TPY_ARRAY_TYPE_CODEC_LIST
+ */
+GPtrArray *
+test_call_codec_list_new (guint n_codecs,
+    guint variant)
+{
+  GPtrArray *codecs = g_ptr_array_sized_new (n_codecs);
+  GHashTable *params;
+  guint i;
+
+  params = g_hash_table_new (g_str_hash, g_str_equal);
+  g_hash_table_insert (params, "mode", "30");
+
+  for (i = 0; i < n_codecs; i++)
+    {
+      gchar *name = g_strdup_printf ("codec%u-%u", i, variant);
+
+      g_ptr_array_add (codecs, tp_value_array_build (5,
+          G_TYPE_UINT, 96 + i,
+          G_TYPE_STRING, name,
+          G_TYPE_UINT, 8000,
+          G_TYPE_UINT, 1,
+          TP_HASH_TYPE_STRING_STRING_MAP, params,
+          G_TYPE_INVALID));
+
+      g_free (name);
+    }
+
+  g_hash_table_unref (params);
+
+  return codecs;
+}
+
+/**
+ * test_call_candidate_list_new:
+ * @n_candidates: the number of candidates
+ * @port_base: where the candidates' ports start, wrapping within the
+ *  valid range
+ *
+ * Returns: a new TPY_ARRAY_TYPE_CANDIDATE_LIST
+ */
+GPtrArray *
+test_call_candidate_list_new (guint n_candidates,
+    guint port_base)
+{
+  GPtrArray *candidates = g_ptr_array_sized_new (n_candidates);
+  guint i;
+
+  for (i = 0; i < n_candidates; i++)
+    {
+      GHashTable *info = tp_asv_new (
+          "protocol", G_TYPE_UINT, TP_MEDIA_STREAM_BASE_PROTO_UDP,
+          "priority", G_TYPE_UINT, 1000 - i,
+          NULL);
+
+      g_ptr_array_add (candidates, tp_value_array_build (4,
+          G_TYPE_UINT, (guint) TPY_STREAM_COMPONENT_DATA,
+          G_TYPE_STRING, "192.0.2.1",
+          G_TYPE_UINT, 1 + (port_base + i) % 65535,
+          TPY_HASH_TYPE_CANDIDATE_INFO, info,
+          G_TYPE_INVALID));
+
+      g_hash_table_unref (info);
+    }
+
+  return candidates;
+}
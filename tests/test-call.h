@@ -0,0 +1,103 @@
+/*
+ * test-call.h - Header for the stub call channel and stream
+ * Copyright © 2011 Collabora Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __TEST_CALL_H__
+#define __TEST_CALL_H__
+
+#include <glib-object.h>
+
+#include <telepathy-yell/base-call-channel.h>
+#include <telepathy-yell/base-media-call-content.h>
+#include <telepathy-yell/base-media-call-stream.h>
+#include <telepathy-yell/call-stream-endpoint.h>
+
+#include "test-connection.h"
+
+G_BEGIN_DECLS
+
+typedef struct _TestCallChannel TestCallChannel;
+typedef struct _TestCallChannelPrivate TestCallChannelPrivate;
+typedef struct _TestCallChannelClass TestCallChannelClass;
+
+struct _TestCallChannelClass {
+    TpyBaseCallChannelClass parent_class;
+};
+
+struct _TestCallChannel {
+    TpyBaseCallChannel parent;
+
+    TestCallChannelPrivate *priv;
+};
+
+GType test_call_channel_get_type (void);
+
+#define TEST_TYPE_CALL_CHANNEL \
+  (test_call_channel_get_type ())
+#define TEST_CALL_CHANNEL(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj), TEST_TYPE_CALL_CHANNEL, \
+    TestCallChannel))
+#define TEST_IS_CALL_CHANNEL(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj), TEST_TYPE_CALL_CHANNEL))
+
+typedef struct _TestCallStream TestCallStream;
+typedef struct _TestCallStreamClass TestCallStreamClass;
+
+struct _TestCallStreamClass {
+    TpyBaseMediaCallStreamClass parent_class;
+};
+
+struct _TestCallStream {
+    TpyBaseMediaCallStream parent;
+
+    /* number of CandidatesPrepared calls */
+    guint candidates_prepared;
+};
+
+GType test_call_stream_get_type (void);
+
+#define TEST_TYPE_CALL_STREAM \
+  (test_call_stream_get_type ())
+#define TEST_CALL_STREAM(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj), TEST_TYPE_CALL_STREAM, \
+    TestCallStream))
+#define TEST_IS_CALL_STREAM(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj), TEST_TYPE_CALL_STREAM))
+
+TestCallChannel *test_call_channel_new (TestConnection *conn,
+    TpHandle peer,
+    gboolean requested);
+
+TpyBaseMediaCallContent *test_call_channel_add_content (
+    TestCallChannel *self,
+    const gchar *name,
+    TpMediaStreamType media);
+
+TestCallStream *test_call_content_get_stream (
+    TpyBaseMediaCallContent *content);
+TpyCallStreamEndpoint *test_call_stream_get_endpoint (
+    TestCallStream *self);
+
+GPtrArray *test_call_codec_list_new (guint n_codecs,
+    guint variant);
+GPtrArray *test_call_candidate_list_new (guint n_candidates,
+    guint port_base);
+
+G_END_DECLS
+
+#endif /* #ifndef __TEST_CALL_H__*/
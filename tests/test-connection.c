@@ -0,0 +1,403 @@
+/*
+ * test-connection.c - Source for TestConnection
+ * Copyright © 2011 Collabora Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/* A connection to nowhere, for running the base classes against a private
+ * bus. Channels are never requested from it: they are created by whoever
+ * owns it and announced with test_connection_announce_channel(). */
+
+#include "test-connection.h"
+
+#include <telepathy-glib/base-channel.h>
+#include <telepathy-glib/channel-manager.h>
+#include <telepathy-glib/handle-repo-dynamic.h>
+#include <telepathy-glib/util.h>
+
+/* TestChannelManager: keeps announced channels until they are closed */
+
+typedef struct {
+    GObject parent;
+
+    GList *channels;
+} TestChannelManager;
+
+typedef struct {
+    GObjectClass parent_class;
+} TestChannelManagerClass;
+
+static GType test_channel_manager_get_type (void);
+static void channel_manager_iface_init (gpointer, gpointer);
+
+G_DEFINE_TYPE_WITH_CODE (TestChannelManager, test_channel_manager,
+    G_TYPE_OBJECT,
+    G_IMPLEMENT_INTERFACE (TP_TYPE_CHANNEL_MANAGER,
+        channel_manager_iface_init));
+
+static void
+test_channel_manager_init (TestChannelManager *self)
+{
+}
+
+static void
+test_channel_manager_dispose (GObject *object)
+{
+  TestChannelManager *self = (TestChannelManager *) object;
+
+  g_list_foreach (self->channels, (GFunc) g_object_unref, NULL);
+  tp_clear_pointer (&self->channels, g_list_free);
+
+  G_OBJECT_CLASS (test_channel_manager_parent_class)->dispose (object);
+}
+
+static void
+test_channel_manager_class_init (TestChannelManagerClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->dispose = test_channel_manager_dispose;
+}
+
+static void
+test_channel_manager_foreach_channel (TpChannelManager *manager,
+    TpExportableChannelFunc func,
+    gpointer user_data)
+{
+  TestChannelManager *self = (TestChannelManager *) manager;
+  GList *l;
+
+  for (l = self->channels; l != NULL; l = l->next)
+    func (l->data, user_data);
+}
+
+static void
+channel_manager_iface_init (gpointer g_iface,
+    gpointer iface_data)
+{
+  TpChannelManagerIface *iface = g_iface;
+
+  iface->foreach_channel = test_channel_manager_foreach_channel;
+}
+
+static void
+channel_closed_cb (TpExportableChannel *channel,
+    TestChannelManager *self)
+{
+  GList *l = g_list_find (self->channels, channel);
+
+  if (l == NULL)
+    return;
+
+  self->channels = g_list_delete_link (self->channels, l);
+  tp_channel_manager_emit_channel_closed_for_object (self, channel);
+  g_object_unref (channel);
+}
+
+/* TestConnection */
+
+G_DEFINE_TYPE (TestConnection, test_connection, TP_TYPE_BASE_CONNECTION);
+
+enum
+{
+  PROP_ACCOUNT = 1,
+  LAST_PROPERTY
+};
+
+struct _TestConnectionPrivate
+{
+  gchar *account;
+
+  /* borrowed; owned by TpBaseConnection */
+  TestChannelManager *channel_manager;
+
+  /* contacts handed out by test_connection_ensure_contact() */
+  TpHandleSet *contacts;
+};
+
+static void
+test_connection_init (TestConnection *self)
+{
+  self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self, TEST_TYPE_CONNECTION,
+      TestConnectionPrivate);
+}
+
+static void
+test_connection_get_property (GObject *object,
+    guint property_id,
+    GValue *value,
+    GParamSpec *pspec)
+{
+  TestConnection *self = TEST_CONNECTION (object);
+
+  switch (property_id)
+    {
+      case PROP_ACCOUNT:
+        g_value_set_string (value, self->priv->account);
+        break;
+      default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+        break;
+    }
+}
+
+static void
+test_connection_set_property (GObject *object,
+    guint property_id,
+    const GValue *value,
+    GParamSpec *pspec)
+{
+  TestConnection *self = TEST_CONNECTION (object);
+
+  switch (property_id)
+    {
+      case PROP_ACCOUNT:
+        g_free (self->priv->account);
+        self->priv->account = g_value_dup_string (value);
+        break;
+      default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+        break;
+    }
+}
+
+static void
+test_connection_finalize (GObject *object)
+{
+  TestConnection *self = TEST_CONNECTION (object);
+
+  g_free (self->priv->account);
+
+  G_OBJECT_CLASS (test_connection_parent_class)->finalize (object);
+}
+
+static void
+test_connection_create_handle_repos (TpBaseConnection *conn,
+    TpHandleRepoIface *repos[NUM_TP_HANDLE_TYPES])
+{
+  repos[TP_HANDLE_TYPE_CONTACT] = tp_dynamic_handle_repo_new (
+      TP_HANDLE_TYPE_CONTACT, NULL, NULL);
+}
+
+static GPtrArray *
+test_connection_create_channel_managers (TpBaseConnection *conn)
+{
+  TestConnection *self = TEST_CONNECTION (conn);
+  GPtrArray *managers = g_ptr_array_sized_new (1);
+
+  self->priv->channel_manager = g_object_new (
+      test_channel_manager_get_type (), NULL);
+  g_ptr_array_add (managers, self->priv->channel_manager);
+
+  return managers;
+}
+
+static gchar *
+test_connection_get_unique_connection_name (TpBaseConnection *conn)
+{
+  return g_strdup (TEST_CONNECTION (conn)->priv->account);
+}
+
+static gboolean
+connect_idle (gpointer user_data)
+{
+  test_connection_connect (user_data);
+
+  return FALSE;
+}
+
+static gboolean
+test_connection_start_connecting (TpBaseConnection *conn,
+    GError **error)
+{
+  g_idle_add_full (G_PRIORITY_DEFAULT_IDLE, connect_idle,
+      g_object_ref (conn), g_object_unref);
+
+  return TRUE;
+}
+
+static void
+test_connection_shut_down (TpBaseConnection *conn)
+{
+  TestConnection *self = TEST_CONNECTION (conn);
+
+  tp_clear_pointer (&self->priv->contacts, tp_handle_set_destroy);
+
+  tp_base_connection_finish_shutdown (conn);
+}
+
+static void
+test_connection_class_init (TestConnectionClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  TpBaseConnectionClass *base_class = TP_BASE_CONNECTION_CLASS (klass);
+  GParamSpec *param_spec;
+
+  g_type_class_add_private (klass, sizeof (TestConnectionPrivate));
+
+  object_class->get_property = test_connection_get_property;
+  object_class->set_property = test_connection_set_property;
+  object_class->finalize = test_connection_finalize;
+
+  base_class->create_handle_repos = test_connection_create_handle_repos;
+  base_class->create_channel_managers =
+      test_connection_create_channel_managers;
+  base_class->get_unique_connection_name =
+      test_connection_get_unique_connection_name;
+  base_class->start_connecting = test_connection_start_connecting;
+  base_class->shut_down = test_connection_shut_down;
+
+  param_spec = g_param_spec_string ("account", "Account",
+      "The identifier of the local user",
+      NULL,
+      G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+  g_object_class_install_property (object_class, PROP_ACCOUNT, param_spec);
+}
+
+/**
+ * test_connection_new:
+ * @account: the identifier of the local user
+ *
+ * Returns: a new connection, already registered on the session bus but not
+ *  yet connected
+ */
+TestConnection *
+test_connection_new (const gchar *account)
+{
+  TestConnection *self;
+  gchar *bus_name;
+  gchar *object_path;
+  GError *error = NULL;
+
+  self = g_object_new (TEST_TYPE_CONNECTION,
+      "protocol", "test",
+      "account", account,
+      NULL);
+
+  if (!tp_base_connection_register (TP_BASE_CONNECTION (self), "yell",
+      &bus_name, &object_path, &error))
+    g_error ("Couldn't register the test connection: %s", error->message);
+
+  g_free (bus_name);
+  g_free (object_path);
+
+  return self;
+}
+
+void
+test_connection_connect (TestConnection *self)
+{
+  TpBaseConnection *base = TP_BASE_CONNECTION (self);
+  TpHandleRepoIface *contact_repo;
+  TpHandle self_handle;
+
+  if (base->status == TP_CONNECTION_STATUS_CONNECTED)
+    return;
+
+  if (base->status != TP_CONNECTION_STATUS_CONNECTING)
+    tp_base_connection_change_status (base,
+        TP_CONNECTION_STATUS_CONNECTING,
+        TP_CONNECTION_STATUS_REASON_REQUESTED);
+
+  contact_repo = tp_base_connection_get_handles (base,
+      TP_HANDLE_TYPE_CONTACT);
+  self->priv->contacts = tp_handle_set_new (contact_repo);
+
+  self_handle = test_connection_ensure_contact (self, self->priv->account);
+  tp_base_connection_set_self_handle (base, self_handle);
+
+  tp_base_connection_change_status (base, TP_CONNECTION_STATUS_CONNECTED,
+      TP_CONNECTION_STATUS_REASON_REQUESTED);
+}
+
+static void
+close_channel (gpointer data,
+    gpointer user_data)
+{
+  TP_BASE_CHANNEL_GET_CLASS (data)->close (data);
+}
+
+void
+test_connection_disconnect (TestConnection *self)
+{
+  TpBaseConnection *base = TP_BASE_CONNECTION (self);
+  GList *channels;
+
+  if (base->status == TP_CONNECTION_STATUS_DISCONNECTED)
+    return;
+
+  /* Closing a channel removes it from the list */
+  channels = g_list_copy (self->priv->channel_manager->channels);
+  g_list_foreach (channels, close_channel, NULL);
+  g_list_free (channels);
+
+  tp_base_connection_change_status (base,
+      TP_CONNECTION_STATUS_DISCONNECTED,
+      TP_CONNECTION_STATUS_REASON_REQUESTED);
+}
+
+/**
+ * test_connection_ensure_contact:
+ * @self: a connected #TestConnection
+ * @id: a contact identifier
+ *
+ * Returns: the handle for @id, which stays valid until @self is
+ *  disconnected
+ */
+TpHandle
+test_connection_ensure_contact (TestConnection *self,
+    const gchar *id)
+{
+  TpHandleRepoIface *contact_repo = tp_base_connection_get_handles (
+      TP_BASE_CONNECTION (self), TP_HANDLE_TYPE_CONTACT);
+  TpHandle handle;
+  GError *error = NULL;
+
+  g_return_val_if_fail (self->priv->contacts != NULL, 0);
+
+  handle = tp_handle_ensure (contact_repo, id, NULL, &error);
+
+  if (handle == 0)
+    g_error ("Couldn't get a handle for %s: %s", id, error->message);
+
+  tp_handle_set_add (self->priv->contacts, handle);
+  tp_handle_unref (contact_repo, handle);
+
+  return handle;
+}
+
+/**
+ * test_connection_announce_channel:
+ * @self: a connected #TestConnection
+ * @channel: a channel which is not yet registered on the bus
+ *
+ * Registers @channel and signals it with NewChannels. @self keeps a
+ * reference to @channel until it is closed.
+ */
+void
+test_connection_announce_channel (TestConnection *self,
+    TpExportableChannel *channel)
+{
+  TestChannelManager *manager = self->priv->channel_manager;
+
+  manager->channels = g_list_prepend (manager->channels,
+      g_object_ref (channel));
+  g_signal_connect_object (channel, "closed",
+      G_CALLBACK (channel_closed_cb), manager, 0);
+
+  tp_base_channel_register (TP_BASE_CHANNEL (channel));
+  tp_channel_manager_emit_new_channel (manager, channel, NULL);
+}
@@ -0,0 +1,73 @@
+/*
+ * test-connection.h - Header for TestConnection
+ * Copyright © 2011 Collabora Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __TEST_CONNECTION_H__
+#define __TEST_CONNECTION_H__
+
+#include <glib-object.h>
+#include <telepathy-glib/base-connection.h>
+#include <telepathy-glib/exportable-channel.h>
+
+G_BEGIN_DECLS
+
+typedef struct _TestConnection TestConnection;
+typedef struct _TestConnectionPrivate TestConnectionPrivate;
+typedef struct _TestConnectionClass TestConnectionClass;
+
+struct _TestConnectionClass {
+    TpBaseConnectionClass parent_class;
+};
+
+struct _TestConnection {
+    TpBaseConnection parent;
+
+    TestConnectionPrivate *priv;
+};
+
+GType test_connection_get_type (void);
+
+/* TYPE MACROS */
+#define TEST_TYPE_CONNECTION \
+  (test_connection_get_type ())
+#define TEST_CONNECTION(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj), TEST_TYPE_CONNECTION, TestConnection))
+#define TEST_CONNECTION_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST((klass), TEST_TYPE_CONNECTION, \
+    TestConnectionClass))
+#define TEST_IS_CONNECTION(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj), TEST_TYPE_CONNECTION))
+#define TEST_IS_CONNECTION_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass), TEST_TYPE_CONNECTION))
+#define TEST_CONNECTION_GET_CLASS(obj) \
+  (G_TYPE_INSTANCE_GET_CLASS ((obj), TEST_TYPE_CONNECTION, \
+    TestConnectionClass))
+
+TestConnection *test_connection_new (const gchar *account);
+void test_connection_connect (TestConnection *self);
+void test_connection_disconnect (TestConnection *self);
+
+TpHandle test_connection_ensure_contact (TestConnection *self,
+    const gchar *id);
+
+void test_connection_announce_channel (TestConnection *self,
+    TpExportableChannel *channel);
+
+G_END_DECLS
+
+#endif /* #ifndef __TEST_CONNECTION_H__*/
@@ -178,20 +178,17 @@ class Generator(object):
             self.b('    TpProxySignalConnection *sc)')
             self.b('{')
             self.b('  GValueArray *args = g_value_array_new (%d);' % len(args))
-            self.b('  GValue blank = { 0 };')
             self.b('  guint i;')
             self.b('')
-            self.b('  g_value_init (&blank, G_TYPE_INT);')
-            self.b('')
+            # appending NULL adds zeroed GValues, ready to be initialized
             self.b('  for (i = 0; i < %d; i++)' % len(args))
-            self.b('    g_value_array_append (args, &blank);')
+            self.b('    g_value_array_append (args, NULL);')
             self.b('')
 
             for i, arg in enumerate(args):
                 name, info, tp_type, elt = arg
                 ctype, gtype, marshaller, pointer = info
 
-                self.b('  g_value_unset (args->values + %d);' % i)
                 self.b('  g_value_init (args->values + %d, %s);' % (i, gtype))
 
                 if gtype == 'G_TYPE_STRING':
@@ -213,7 +210,7 @@ class Generator(object):
                     self.b('  g_value_set_uint (args->values + %d, %s);'
                            % (i, name))
                 elif gtype == 'G_TYPE_INT64':
-                    self.b('  g_value_set_int (args->values + %d, %s);'
+                    self.b('  g_value_set_int64 (args->values + %d, %s);'
                            % (i, name))
                 elif gtype == 'G_TYPE_UINT64':
                     self.b('  g_value_set_uint64 (args->values + %d, %s);'
@@ -491,7 +488,6 @@ class Generator(object):
 
         if len(out_args) > 0:
             self.b('  GValueArray *args;')
-            self.b('  GValue blank = { 0 };')
             self.b('  guint i;')
 
             for arg in out_args:
@@ -540,17 +536,15 @@ class Generator(object):
             self.b('    }')
             self.b('')
             self.b('  args = g_value_array_new (%d);' % len(out_args))
-            self.b('  g_value_init (&blank, G_TYPE_INT);')
             self.b('')
             self.b('  for (i = 0; i < %d; i++)' % len(out_args))
-            self.b('    g_value_array_append (args, &blank);')
+            self.b('    g_value_array_append (args, NULL);')
 
             for i, arg in enumerate(out_args):
                 name, info, tp_type, elt = arg
                 ctype, gtype, marshaller, pointer = info
 
                 self.b('')
-                self.b('  g_value_unset (args->values + %d);' % i)
                 self.b('  g_value_init (args->values + %d, %s);' % (i, gtype))
 
                 if gtype == 'G_TYPE_STRING':
@@ -572,10 +566,10 @@ class Generator(object):
                     self.b('  g_value_set_uint (args->values + %d, %s);'
                             % (i, name))
                 elif gtype == 'G_TYPE_INT64':
-                    self.b('  g_value_set_int (args->values + %d, %s);'
+                    self.b('  g_value_set_int64 (args->values + %d, %s);'
                             % (i, name))
                 elif gtype == 'G_TYPE_UINT64':
-                    self.b('  g_value_set_uint (args->values + %d, %s);'
+                    self.b('  g_value_set_uint64 (args->values + %d, %s);'
                             % (i, name))
                 elif gtype == 'G_TYPE_DOUBLE':
                     self.b('  g_value_set_double (args->values + %d, %s);'
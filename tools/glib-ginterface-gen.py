@@ -270,6 +270,13 @@ class Generator(object):
                     flags = ('TP_DBUS_PROPERTIES_MIXIN_FLAG_READ | '
                              'TP_DBUS_PROPERTIES_MIXIN_FLAG_WRITE')
 
+                emits = self.get_emits_changed(m, interface)
+
+                if emits == 'true':
+                    flags += ' | TP_DBUS_PROPERTIES_MIXIN_FLAG_EMITS_CHANGED'
+                elif emits == 'invalidates':
+                    flags += ' | TP_DBUS_PROPERTIES_MIXIN_FLAG_EMITS_INVALIDATED'
+
                 self.b('      { 0, %s, "%s", 0, NULL, NULL }, /* %s */'
                        % (flags, m.getAttribute('type'), m.getAttribute('name')))
 
@@ -638,6 +645,11 @@ class Generator(object):
             if pointer:
                 ctype = 'const ' + ctype
 
+            # The D-Bus glue marshals the arguments before g_signal_emit
+            # returns, so there's no need for GLib to copy them first
+            if marshaller in ('BOXED', 'STRING'):
+                gtype = gtype + ' | G_SIGNAL_TYPE_STATIC_SCOPE'
+
             struct = (ctype, name, gtype)
             args.append(struct)
 
@@ -703,6 +715,17 @@ class Generator(object):
 
         return in_base_init
 
+    def get_emits_changed(self, property, interface):
+        # the property's own annotation overrides the interface's
+        for node in (property, interface):
+            for child in node.childNodes:
+                if (child.nodeType == child.ELEMENT_NODE and
+                    child.localName == 'annotation' and
+                    child.getAttribute('name') ==
+                        'org.freedesktop.DBus.Property.EmitsChangedSignal'):
+                    return child.getAttribute('value')
+        return None
+
     def have_properties(self, nodes):
         for node in nodes:
             interface =  node.getElementsByTagName('interface')[0]